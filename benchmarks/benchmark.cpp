@@ -0,0 +1,319 @@
+// SPDX-FileCopyrightText: (c) 2020 Silverlan <opensource@pragma-engine.com>
+// SPDX-License-Identifier: MIT
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <iomanip>
+#include <sstream>
+
+import pragma.util;
+import pr_dmx_benchmark.generator;
+import source_engine.dmx;
+
+// Native benchmarks for loading and traversing DMX files. The cost of the Lua bindings is measured by benchmarks/lua/marshalling.lua,
+// which has to run inside of Pragma.
+//
+// Usage:
+//   pr_dmx_benchmark generate <preset> <binary|text> <outputFile>
+//   pr_dmx_benchmark run [--iterations N] [--output results.json] <files...>
+//   pr_dmx_benchmark suite [--dir directory] [--presets small,medium,...] [--iterations N] [--output results.json]
+namespace pr_dmx_benchmark {
+	struct Timings {
+		std::vector<double> samples;
+		double GetMin() const { return samples.empty() ? 0.0 : *std::min_element(samples.begin(), samples.end()); }
+		double GetMean() const { return samples.empty() ? 0.0 : std::accumulate(samples.begin(), samples.end(), 0.0) / samples.size(); }
+		double GetMedian() const
+		{
+			if(samples.empty())
+				return 0.0;
+			auto sorted = samples;
+			std::sort(sorted.begin(), sorted.end());
+			return sorted[sorted.size() / 2];
+		}
+	};
+	struct TraversalStats {
+		uint64_t elements = 0;
+		uint64_t attributes = 0;
+		uint64_t arrayEntries = 0;
+		double checksum = 0.0; // Prevents the value reads from being optimized out
+	};
+	struct FileResult {
+		std::string path;
+		uint64_t fileSize = 0;
+		uint32_t iterations = 0;
+		TraversalStats stats;
+		Timings read;
+		Timings load;
+		Timings traverse;
+		std::string error;
+	};
+
+	static double get_elapsed_ms(std::chrono::steady_clock::time_point start) { return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count(); }
+
+	static void traverse_value(const source_engine::dmx::Attribute &attr, TraversalStats &stats)
+	{
+		++stats.attributes;
+		if(attr.data == nullptr)
+			return;
+		auto *data = attr.data.get();
+		switch(attr.type) {
+		case source_engine::dmx::AttrType::Element:
+			stats.checksum += static_cast<std::weak_ptr<source_engine::dmx::Element> *>(data)->expired() ? 0.0 : 1.0;
+			break;
+		case source_engine::dmx::AttrType::String:
+			stats.checksum += static_cast<std::string *>(data)->size();
+			break;
+		case source_engine::dmx::AttrType::Int:
+			stats.checksum += *static_cast<int32_t *>(data);
+			break;
+		case source_engine::dmx::AttrType::Float:
+		case source_engine::dmx::AttrType::Time:
+		case source_engine::dmx::AttrType::Vector2:
+		case source_engine::dmx::AttrType::Vector3:
+		case source_engine::dmx::AttrType::Vector4:
+		case source_engine::dmx::AttrType::Angle:
+		case source_engine::dmx::AttrType::Quaternion:
+		case source_engine::dmx::AttrType::Matrix:
+			// Only the first component is read, the vector types are plain float aggregates
+			stats.checksum += *static_cast<float *>(data);
+			break;
+		case source_engine::dmx::AttrType::Bool:
+			stats.checksum += *static_cast<bool *>(data) ? 1.0 : 0.0;
+			break;
+		case source_engine::dmx::AttrType::Binary:
+			stats.checksum += static_cast<std::vector<uint8_t> *>(data)->size();
+			break;
+		default:
+			{
+				if(attr.type >= source_engine::dmx::AttrType::ArrayFirst && attr.type <= source_engine::dmx::AttrType::ArrayLast) {
+					auto &vdata = *static_cast<std::vector<std::shared_ptr<source_engine::dmx::Attribute>> *>(data);
+					stats.arrayEntries += vdata.size();
+					for(auto &subAttr : vdata) {
+						if(subAttr)
+							traverse_value(*subAttr, stats);
+					}
+				}
+				break;
+			}
+		}
+	}
+
+	static TraversalStats traverse(source_engine::dmx::FileData &fd)
+	{
+		TraversalStats stats {};
+		for(auto &el : fd.GetElements()) {
+			if(el == nullptr)
+				continue;
+			++stats.elements;
+			stats.checksum += el->name.size() + el->type.size();
+			for(auto &pair : el->attributes) {
+				if(pair.second)
+					traverse_value(*pair.second, stats);
+			}
+		}
+		return stats;
+	}
+
+	static FileResult run_file(const std::string &path, uint32_t iterations)
+	{
+		FileResult result {};
+		result.path = path;
+		result.iterations = iterations;
+		for(auto i = 0u; i < iterations; ++i) {
+			auto t = std::chrono::steady_clock::now();
+			std::ifstream stream {path, std::ios::binary | std::ios::ate};
+			if(!stream) {
+				result.error = "Unable to open file";
+				return result;
+			}
+			std::vector<uint8_t> buffer(static_cast<size_t>(stream.tellg()));
+			stream.seekg(0);
+			stream.read(reinterpret_cast<char *>(buffer.data()), buffer.size());
+			result.read.samples.push_back(get_elapsed_ms(t));
+			result.fileSize = buffer.size();
+
+			t = std::chrono::steady_clock::now();
+			std::shared_ptr<source_engine::dmx::FileData> fd = nullptr;
+			try {
+				fd = source_engine::dmx::FileData::Load(std::make_shared<ufile::MemoryFile>(buffer.data(), buffer.size()));
+			}
+			catch(const std::exception &e) {
+				result.error = e.what();
+				return result;
+			}
+			if(fd == nullptr) {
+				result.error = "Unable to parse file";
+				return result;
+			}
+			result.load.samples.push_back(get_elapsed_ms(t));
+
+			t = std::chrono::steady_clock::now();
+			result.stats = traverse(*fd);
+			result.traverse.samples.push_back(get_elapsed_ms(t));
+		}
+		return result;
+	}
+
+	static std::string escape_json(const std::string &str)
+	{
+		std::string out;
+		out.reserve(str.size());
+		for(auto c : str) {
+			if(c == '"' || c == '\\')
+				out += '\\';
+			out += c;
+		}
+		return out;
+	}
+
+	static void write_timings(std::ostream &os, const char *name, const Timings &timings)
+	{
+		os << "\"" << name << "\": {\"min\": " << timings.GetMin() << ", \"median\": " << timings.GetMedian() << ", \"mean\": " << timings.GetMean() << "}";
+	}
+
+	static void write_json(std::ostream &os, const std::vector<FileResult> &results)
+	{
+		os << "{\n\t\"version\": 1,\n\t\"results\": [";
+		for(auto i = 0u; i < results.size(); ++i) {
+			auto &r = results[i];
+			os << ((i > 0) ? ",\n" : "\n") << "\t\t{";
+			os << "\"file\": \"" << escape_json(std::filesystem::path {r.path}.filename().string()) << "\", ";
+			os << "\"fileSize\": " << r.fileSize << ", ";
+			os << "\"iterations\": " << r.iterations << ", ";
+			if(!r.error.empty()) {
+				os << "\"error\": \"" << escape_json(r.error) << "\"}";
+				continue;
+			}
+			os << "\"elements\": " << r.stats.elements << ", ";
+			os << "\"attributes\": " << r.stats.attributes << ", ";
+			os << "\"arrayEntries\": " << r.stats.arrayEntries << ", ";
+			write_timings(os, "read_ms", r.read);
+			os << ", ";
+			write_timings(os, "load_ms", r.load);
+			os << ", ";
+			write_timings(os, "traverse_ms", r.traverse);
+			auto loadMs = r.load.GetMedian();
+			os << ", \"load_mb_per_s\": " << ((loadMs > 0.0) ? (r.fileSize / (1'024.0 * 1'024.0)) / (loadMs / 1'000.0) : 0.0);
+			auto numAttrs = std::max<uint64_t>(r.stats.attributes, 1);
+			os << ", \"traverse_ns_per_attribute\": " << (r.traverse.GetMedian() * 1'000'000.0) / numAttrs;
+			os << "}";
+		}
+		os << "\n\t]\n}\n";
+	}
+
+	static int output_results(const std::vector<FileResult> &results, const std::string &outputPath)
+	{
+		if(outputPath.empty())
+			write_json(std::cout, results);
+		else {
+			std::ofstream stream {outputPath};
+			if(!stream) {
+				std::cerr << "Unable to write '" << outputPath << "'\n";
+				return 1;
+			}
+			write_json(stream, results);
+		}
+		auto failed = std::any_of(results.begin(), results.end(), [](const FileResult &r) { return !r.error.empty(); });
+		return failed ? 1 : 0;
+	}
+
+	static std::vector<std::string> split(const std::string &str, char delimiter)
+	{
+		std::vector<std::string> parts;
+		std::stringstream ss {str};
+		std::string part;
+		while(std::getline(ss, part, delimiter)) {
+			if(!part.empty())
+				parts.push_back(part);
+		}
+		return parts;
+	}
+};
+
+int main(int argc, char *argv[])
+{
+	using namespace pr_dmx_benchmark;
+	std::vector<std::string> args {argv + 1, argv + argc};
+	if(args.empty()) {
+		std::cerr << "Usage: pr_dmx_benchmark <generate|run|suite> ...\n";
+		return 1;
+	}
+	auto mode = args.front();
+	args.erase(args.begin());
+
+	uint32_t iterations = 5;
+	std::string outputPath;
+	std::string dir = "dmx_benchmark_data";
+	auto presets = get_preset_names();
+	presets.pop_back(); // "huge" has to be requested explicitly
+	std::vector<std::string> positional;
+	for(size_t i = 0; i < args.size(); ++i) {
+		auto hasValue = (i + 1 < args.size());
+		if(args[i] == "--iterations" && hasValue)
+			iterations = std::max(std::stoi(args[++i]), 1);
+		else if(args[i] == "--output" && hasValue)
+			outputPath = args[++i];
+		else if(args[i] == "--dir" && hasValue)
+			dir = args[++i];
+		else if(args[i] == "--presets" && hasValue)
+			presets = split(args[++i], ',');
+		else
+			positional.push_back(args[i]);
+	}
+
+	if(mode == "generate") {
+		if(positional.size() != 3) {
+			std::cerr << "Usage: pr_dmx_benchmark generate <preset> <binary|text> <outputFile>\n";
+			return 1;
+		}
+		auto settings = get_preset(positional[0]);
+		auto encoding = encoding_from_string(positional[1]);
+		if(!settings.has_value() || !encoding.has_value()) {
+			std::cerr << "Unknown preset or encoding\n";
+			return 1;
+		}
+		std::string err;
+		if(!generate(*settings, *encoding, positional[2], err)) {
+			std::cerr << err << "\n";
+			return 1;
+		}
+		return 0;
+	}
+	if(mode == "run") {
+		std::vector<FileResult> results;
+		for(auto &path : positional)
+			results.push_back(run_file(path, iterations));
+		return output_results(results, outputPath);
+	}
+	if(mode == "suite") {
+		std::filesystem::create_directories(dir);
+		std::vector<FileResult> results;
+		for(auto &presetName : presets) {
+			auto settings = get_preset(presetName);
+			if(!settings.has_value()) {
+				std::cerr << "Unknown preset '" << presetName << "'\n";
+				return 1;
+			}
+			// Files generated with different settings (or by an older generator) have a different name and are never reused
+			std::stringstream hash;
+			hash << std::hex << std::setw(16) << std::setfill('0') << get_settings_hash(*settings);
+			for(auto encoding : {Encoding::Binary, Encoding::Text}) {
+				auto path = (std::filesystem::path {dir} / (presetName + "_" + hash.str() + "_" + encoding_to_string(encoding) + ".dmx")).string();
+				std::string err;
+				if(!std::filesystem::exists(path) && !generate(*settings, encoding, path, err)) {
+					std::cerr << err << "\n";
+					return 1;
+				}
+				results.push_back(run_file(path, iterations));
+			}
+		}
+		return output_results(results, outputPath);
+	}
+	std::cerr << "Unknown mode '" << mode << "'\n";
+	return 1;
+}
@@ -0,0 +1,624 @@
+// SPDX-FileCopyrightText: (c) 2020 Silverlan <opensource@pragma-engine.com>
+// SPDX-License-Identifier: MIT
+
+module;
+
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <optional>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+module pr_dmx_benchmark.generator;
+
+namespace pr_dmx_benchmark {
+	// Attribute type ids as used by the binary DMX encoding (version 5). Array types are offset by ARRAY_OFFSET.
+	enum class Type : uint8_t {
+		Element = 1,
+		Int,
+		Float,
+		Bool,
+		String,
+		Binary,
+		Time,
+		Color,
+		Vector2,
+		Vector3,
+		Vector4,
+		Angle,
+		Quaternion,
+		Matrix,
+	};
+	static constexpr uint8_t ARRAY_OFFSET = 14;
+	static constexpr int32_t INVALID_ELEMENT = -1;
+
+	// Values are stored flattened: all float-based types in 'floats', Bool/Color/Binary in 'bytes'.
+	// For arrays 'count' is the number of entries, for Binary values it is the number of bytes.
+	struct Attribute {
+		std::string name;
+		Type type;
+		bool isArray = false;
+		uint32_t count = 1;
+		std::vector<float> floats;
+		std::vector<int32_t> ints;
+		std::vector<uint8_t> bytes;
+		std::vector<std::string> strings;
+	};
+	struct Element {
+		std::string type;
+		std::string name;
+		std::array<uint8_t, 16> guid;
+		std::vector<Attribute> attributes;
+	};
+
+	class Document {
+	  public:
+		Document(uint32_t seed) : m_rng {seed} {}
+		int32_t AddElement(const std::string &type, const std::string &name)
+		{
+			Element el {type, name, {}, {}};
+			for(auto &b : el.guid)
+				b = static_cast<uint8_t>(m_rng() & 0xFF);
+			m_elements.push_back(std::move(el));
+			return static_cast<int32_t>(m_elements.size() - 1);
+		}
+		Attribute &AddAttribute(int32_t el, const std::string &name, Type type, bool isArray = false)
+		{
+			auto &attrs = m_elements[el].attributes;
+			attrs.push_back({name, type, isArray, isArray ? 0u : 1u, {}, {}, {}, {}});
+			return attrs.back();
+		}
+		void SetElement(int32_t el, const std::string &name, int32_t target) { AddAttribute(el, name, Type::Element).ints = {target}; }
+		void SetString(int32_t el, const std::string &name, const std::string &value) { AddAttribute(el, name, Type::String).strings = {value}; }
+		void SetInt(int32_t el, const std::string &name, int32_t value) { AddAttribute(el, name, Type::Int).ints = {value}; }
+		void SetFloat(int32_t el, const std::string &name, float value) { AddAttribute(el, name, Type::Float).floats = {value}; }
+		void SetBool(int32_t el, const std::string &name, bool value) { AddAttribute(el, name, Type::Bool).bytes = {static_cast<uint8_t>(value ? 1 : 0)}; }
+		Attribute &SetElementArray(int32_t el, const std::string &name, std::vector<int32_t> targets)
+		{
+			auto &attr = AddAttribute(el, name, Type::Element, true);
+			attr.count = static_cast<uint32_t>(targets.size());
+			attr.ints = std::move(targets);
+			return attr;
+		}
+		float RandomFloat(float min, float max) { return std::uniform_real_distribution<float> {min, max}(m_rng); }
+		int32_t RandomInt(int32_t min, int32_t max) { return std::uniform_int_distribution<int32_t> {min, max}(m_rng); }
+		const std::vector<Element> &GetElements() const { return m_elements; }
+	  private:
+		std::mt19937 m_rng;
+		std::vector<Element> m_elements;
+	};
+
+	static uint32_t get_component_count(Type type)
+	{
+		switch(type) {
+		case Type::Vector2:
+			return 2;
+		case Type::Vector3:
+		case Type::Angle:
+			return 3;
+		case Type::Vector4:
+		case Type::Quaternion:
+		case Type::Color:
+			return 4;
+		case Type::Matrix:
+			return 16;
+		default:
+			return 1;
+		}
+	}
+
+	static void build_document(Document &doc, const GeneratorSettings &settings)
+	{
+		auto root = doc.AddElement("DmElement", "session");
+		auto settingsEl = doc.AddElement("DmElement", "sessionSettings");
+		doc.SetElement(root, "settings", settingsEl);
+		doc.SetString(settingsEl, "comment", "Synthetic benchmark session");
+		doc.SetInt(settingsEl, "frameRate", 24);
+		doc.SetBool(settingsEl, "enabled", true);
+		doc.SetFloat(settingsEl, "scale", 1.f);
+		doc.AddAttribute(settingsEl, "backgroundColor", Type::Color).bytes = {64, 64, 64, 255};
+
+		// Animation sets with channels, logs and log layers
+		static const std::array<std::pair<const char *, Type>, 3> logTypes {std::pair<const char *, Type> {"DmeVector3Log", Type::Vector3}, {"DmeQuaternionLog", Type::Quaternion}, {"DmeFloatLog", Type::Float}};
+		std::vector<int32_t> animationSets;
+		for(auto i = 0u; i < settings.animationSets; ++i) {
+			auto set = doc.AddElement("DmeAnimationSet", "animationSet" + std::to_string(i));
+			animationSets.push_back(set);
+			std::vector<int32_t> channels;
+			for(auto j = 0u; j < settings.channelsPerSet; ++j) {
+				auto &logType = logTypes[j % logTypes.size()];
+				auto channel = doc.AddElement("DmeChannel", "channel" + std::to_string(j));
+				channels.push_back(channel);
+				doc.SetString(channel, "fromAttribute", "value");
+				doc.SetString(channel, "toAttribute", (logType.second == Type::Quaternion) ? "orientation" : "position");
+				doc.SetInt(channel, "mode", 3);
+
+				auto log = doc.AddElement(logType.first, "log");
+				doc.SetElement(channel, "log", log);
+				doc.SetBool(log, "usedefaultvalue", false);
+				auto layer = doc.AddElement(std::string {logType.first} + "Layer", "layer");
+				doc.SetElementArray(log, "layers", {layer});
+
+				auto &times = doc.AddAttribute(layer, "times", Type::Time, true);
+				times.count = settings.keysPerLog;
+				times.floats.resize(settings.keysPerLog);
+				for(auto k = 0u; k < settings.keysPerLog; ++k)
+					times.floats[k] = static_cast<float>(k) / 24.f;
+
+				auto &curveTypes = doc.AddAttribute(layer, "curvetypes", Type::Int, true);
+				curveTypes.count = settings.keysPerLog;
+				curveTypes.ints.assign(settings.keysPerLog, 0);
+
+				auto &values = doc.AddAttribute(layer, "values", logType.second, true);
+				values.count = settings.keysPerLog;
+				auto numComponents = get_component_count(logType.second);
+				values.floats.resize(settings.keysPerLog * numComponents);
+				for(auto &v : values.floats)
+					v = doc.RandomFloat(-100.f, 100.f);
+				if(logType.second == Type::Quaternion) {
+					for(auto k = 0u; k < settings.keysPerLog; ++k) {
+						auto *q = values.floats.data() + k * 4;
+						auto len = std::sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+						for(auto c = 0u; c < 4; ++c)
+							q[c] /= len;
+					}
+				}
+			}
+			doc.SetElementArray(set, "channels", channels);
+		}
+		doc.SetElementArray(root, "animationSets", animationSets);
+
+		// Meshes with per-face-vertex indexed vertex streams
+		std::vector<int32_t> meshes;
+		auto material = doc.AddElement("DmeMaterial", "material");
+		doc.SetString(material, "mtlName", "models/benchmark/default");
+		for(auto i = 0u; i < settings.meshes; ++i) {
+			auto mesh = doc.AddElement("DmeMesh", "mesh" + std::to_string(i));
+			meshes.push_back(mesh);
+			auto vertexData = doc.AddElement("DmeVertexData", "bind");
+			doc.SetElement(mesh, "bindState", vertexData);
+			doc.SetElement(mesh, "currentState", vertexData);
+			auto &format = doc.AddAttribute(vertexData, "vertexFormat", Type::String, true);
+			format.strings = {"positions", "normals", "textureCoordinates", "jointWeights", "jointIndices"};
+			format.count = static_cast<uint32_t>(format.strings.size());
+			doc.SetInt(vertexData, "jointCount", 2);
+			doc.SetBool(vertexData, "flipVCoordinates", false);
+
+			auto numVerts = settings.verticesPerMesh;
+			auto addStream = [&](const std::string &name, Type type) {
+				auto &attr = doc.AddAttribute(vertexData, name, type, true);
+				attr.count = numVerts;
+				attr.floats.resize(numVerts * get_component_count(type));
+				for(auto &v : attr.floats)
+					v = doc.RandomFloat(-1.f, 1.f);
+			};
+			addStream("positions", Type::Vector3);
+			addStream("normals", Type::Vector3);
+			addStream("textureCoordinates", Type::Vector2);
+			auto &weights = doc.AddAttribute(vertexData, "jointWeights", Type::Float, true);
+			weights.count = numVerts * 2;
+			weights.floats.resize(weights.count);
+			for(auto v = 0u; v < numVerts; ++v) {
+				auto w = doc.RandomFloat(0.f, 1.f);
+				weights.floats[v * 2] = w;
+				weights.floats[v * 2 + 1] = 1.f - w;
+			}
+			auto &jointIndices = doc.AddAttribute(vertexData, "jointIndices", Type::Int, true);
+			jointIndices.count = numVerts * 2;
+			jointIndices.ints.resize(jointIndices.count);
+			for(auto &idx : jointIndices.ints)
+				idx = doc.RandomInt(0, 63);
+
+			// Quads over a strip of vertices; every face-vertex refers to the same index in all streams
+			std::vector<int32_t> faceVertexIndices;
+			std::vector<int32_t> faces;
+			auto numQuads = (numVerts >= 4) ? (numVerts - 2) / 2 : 0;
+			for(auto q = 0u; q < numQuads; ++q) {
+				std::array<int32_t, 4> quad {static_cast<int32_t>(q * 2), static_cast<int32_t>(q * 2 + 1), static_cast<int32_t>(q * 2 + 3), static_cast<int32_t>(q * 2 + 2)};
+				for(auto idx : quad) {
+					faces.push_back(static_cast<int32_t>(faceVertexIndices.size()));
+					faceVertexIndices.push_back(idx);
+				}
+				faces.push_back(-1);
+			}
+			for(auto *name : {"positionsIndices", "normalsIndices", "textureCoordinatesIndices"}) {
+				auto &attr = doc.AddAttribute(vertexData, name, Type::Int, true);
+				attr.count = static_cast<uint32_t>(faceVertexIndices.size());
+				attr.ints = faceVertexIndices;
+			}
+			auto faceSet = doc.AddElement("DmeFaceSet", "faceSet");
+			doc.SetElementArray(mesh, "faceSets", {faceSet});
+			doc.SetElement(faceSet, "material", material);
+			auto &facesAttr = doc.AddAttribute(faceSet, "faces", Type::Int, true);
+			facesAttr.count = static_cast<uint32_t>(faces.size());
+			facesAttr.ints = std::move(faces);
+		}
+		doc.SetElementArray(root, "meshes", meshes);
+
+		// Deep linked chain
+		auto prev = root;
+		auto prevAttrName = std::string {"chain"};
+		for(auto i = 0u; i < settings.chainDepth; ++i) {
+			auto el = doc.AddElement("DmeTransform", "chain" + std::to_string(i));
+			doc.SetElement(prev, prevAttrName, el);
+			auto &pos = doc.AddAttribute(el, "position", Type::Vector3);
+			pos.floats = {doc.RandomFloat(-1.f, 1.f), doc.RandomFloat(-1.f, 1.f), doc.RandomFloat(-1.f, 1.f)};
+			doc.AddAttribute(el, "orientation", Type::Quaternion).floats = {0.f, 0.f, 0.f, 1.f};
+			doc.AddAttribute(el, "angles", Type::Angle).floats = {0.f, 90.f, 0.f};
+			doc.AddAttribute(el, "color", Type::Vector4).floats = {1.f, 1.f, 1.f, 1.f};
+			doc.AddAttribute(el, "uv", Type::Vector2).floats = {0.5f, 0.5f};
+			auto &mat = doc.AddAttribute(el, "matrix", Type::Matrix);
+			mat.floats.assign(16, 0.f);
+			for(auto c = 0u; c < 4; ++c)
+				mat.floats[c * 4 + c] = 1.f;
+			auto &blob = doc.AddAttribute(el, "blob", Type::Binary);
+			blob.count = 32;
+			blob.bytes.resize(blob.count);
+			for(auto &b : blob.bytes)
+				b = static_cast<uint8_t>(doc.RandomInt(0, 255));
+			auto &time = doc.AddAttribute(el, "time", Type::Time);
+			time.floats = {static_cast<float>(i) * 0.5f};
+			prev = el;
+			prevAttrName = "next";
+		}
+		doc.SetElement(prev, prevAttrName, INVALID_ELEMENT);
+	}
+
+	class BinaryWriter {
+	  public:
+		BinaryWriter(std::ofstream &stream) : m_stream {stream} {}
+		template<typename T>
+		void Write(const T &value)
+		{
+			m_stream.write(reinterpret_cast<const char *>(&value), sizeof(value));
+		}
+		void Write(const void *data, size_t size) { m_stream.write(static_cast<const char *>(data), size); }
+		void WriteString(const std::string &str) { m_stream.write(str.c_str(), str.size() + 1); }
+	  private:
+		std::ofstream &m_stream;
+	};
+
+	static void write_binary(const Document &doc, std::ofstream &stream)
+	{
+		auto &elements = doc.GetElements();
+		std::vector<std::string> strings;
+		std::unordered_map<std::string, int32_t> stringIds;
+		auto getStringId = [&](const std::string &str) {
+			auto it = stringIds.find(str);
+			if(it != stringIds.end())
+				return it->second;
+			auto id = static_cast<int32_t>(strings.size());
+			strings.push_back(str);
+			stringIds[str] = id;
+			return id;
+		};
+		for(auto &el : elements) {
+			getStringId(el.type);
+			getStringId(el.name);
+			for(auto &attr : el.attributes) {
+				getStringId(attr.name);
+				if(attr.type == Type::String && !attr.isArray)
+					getStringId(attr.strings.front());
+			}
+		}
+
+		stream << "<!-- dmx encoding binary 5 format model 18 -->\n";
+		stream.put('\0');
+		BinaryWriter writer {stream};
+		writer.Write<int32_t>(static_cast<int32_t>(strings.size()));
+		for(auto &str : strings)
+			writer.WriteString(str);
+
+		writer.Write<int32_t>(static_cast<int32_t>(elements.size()));
+		for(auto &el : elements) {
+			writer.Write<int32_t>(getStringId(el.type));
+			writer.Write<int32_t>(getStringId(el.name));
+			writer.Write(el.guid.data(), el.guid.size());
+		}
+
+		auto writeValue = [&writer](const Attribute &attr, uint32_t i) {
+			auto numComponents = get_component_count(attr.type);
+			switch(attr.type) {
+			case Type::Element:
+			case Type::Int:
+				writer.Write<int32_t>(attr.ints[i]);
+				break;
+			case Type::Float:
+			case Type::Vector2:
+			case Type::Vector3:
+			case Type::Vector4:
+			case Type::Angle:
+			case Type::Matrix:
+				writer.Write(attr.floats.data() + i * numComponents, numComponents * sizeof(float));
+				break;
+			case Type::Quaternion:
+				// Stored as x, y, z, w
+				writer.Write(attr.floats.data() + i * numComponents, numComponents * sizeof(float));
+				break;
+			case Type::Time:
+				// Ticks of 1/10000 seconds
+				writer.Write<int32_t>(static_cast<int32_t>(std::lround(attr.floats[i] * 10'000.f)));
+				break;
+			case Type::Bool:
+				writer.Write<uint8_t>(attr.bytes[i]);
+				break;
+			case Type::Color:
+				writer.Write(attr.bytes.data() + i * 4, 4);
+				break;
+			case Type::String:
+				// Only array entries are stored inline, single string values are string table references
+				writer.WriteString(attr.strings[i]);
+				break;
+			case Type::Binary:
+				writer.Write<int32_t>(static_cast<int32_t>(attr.bytes.size()));
+				writer.Write(attr.bytes.data(), attr.bytes.size());
+				break;
+			}
+		};
+		for(auto &el : elements) {
+			writer.Write<int32_t>(static_cast<int32_t>(el.attributes.size()));
+			for(auto &attr : el.attributes) {
+				writer.Write<int32_t>(getStringId(attr.name));
+				writer.Write<uint8_t>(static_cast<uint8_t>(attr.type) + (attr.isArray ? ARRAY_OFFSET : 0));
+				if(attr.isArray) {
+					writer.Write<int32_t>(static_cast<int32_t>(attr.count));
+					for(auto i = 0u; i < attr.count; ++i)
+						writeValue(attr, i);
+					continue;
+				}
+				if(attr.type == Type::String) {
+					writer.Write<int32_t>(getStringId(attr.strings.front()));
+					continue;
+				}
+				writeValue(attr, 0);
+			}
+		}
+	}
+
+	static std::string guid_to_string(const std::array<uint8_t, 16> &guid)
+	{
+		static const char *hex = "0123456789abcdef";
+		std::string str;
+		str.reserve(36);
+		for(auto i = 0u; i < guid.size(); ++i) {
+			if(i == 4 || i == 6 || i == 8 || i == 10)
+				str += '-';
+			str += hex[guid[i] >> 4];
+			str += hex[guid[i] & 0xF];
+		}
+		return str;
+	}
+
+	static const char *get_text_type_name(Type type)
+	{
+		switch(type) {
+		case Type::Element:
+			return "element";
+		case Type::Int:
+			return "int";
+		case Type::Float:
+			return "float";
+		case Type::Bool:
+			return "bool";
+		case Type::String:
+			return "string";
+		case Type::Binary:
+			return "binary";
+		case Type::Time:
+			return "time";
+		case Type::Color:
+			return "color";
+		case Type::Vector2:
+			return "vector2";
+		case Type::Vector3:
+			return "vector3";
+		case Type::Vector4:
+			return "vector4";
+		case Type::Angle:
+			return "qangle";
+		case Type::Quaternion:
+			return "quaternion";
+		case Type::Matrix:
+			return "matrix";
+		}
+		return "";
+	}
+
+	static void write_text(const Document &doc, std::ofstream &stream)
+	{
+		auto &elements = doc.GetElements();
+		std::vector<std::string> guids;
+		guids.reserve(elements.size());
+		for(auto &el : elements)
+			guids.push_back(guid_to_string(el.guid));
+
+		std::string value;
+		std::array<char, 32> buf;
+		auto appendFloat = [&value, &buf](float f) {
+			auto res = std::to_chars(buf.data(), buf.data() + buf.size(), f);
+			value.append(buf.data(), res.ptr);
+		};
+		auto formatValue = [&](const Attribute &attr, uint32_t i) {
+			value.clear();
+			auto numComponents = get_component_count(attr.type);
+			switch(attr.type) {
+			case Type::Element:
+				if(attr.ints[i] != INVALID_ELEMENT)
+					value = guids[attr.ints[i]];
+				break;
+			case Type::Int:
+				value = std::to_string(attr.ints[i]);
+				break;
+			case Type::Float:
+			case Type::Time:
+			case Type::Vector2:
+			case Type::Vector3:
+			case Type::Vector4:
+			case Type::Angle:
+			case Type::Quaternion:
+			case Type::Matrix:
+				for(auto c = 0u; c < numComponents; ++c) {
+					if(c > 0)
+						value += ' ';
+					appendFloat(attr.floats[i * numComponents + c]);
+				}
+				break;
+			case Type::Bool:
+				value = attr.bytes[i] ? "1" : "0";
+				break;
+			case Type::Color:
+				for(auto c = 0u; c < 4; ++c) {
+					if(c > 0)
+						value += ' ';
+					value += std::to_string(attr.bytes[i * 4 + c]);
+				}
+				break;
+			case Type::String:
+				value = attr.strings[i];
+				break;
+			case Type::Binary:
+				{
+					static const char *hex = "0123456789ABCDEF";
+					for(auto b : attr.bytes) {
+						value += hex[b >> 4];
+						value += hex[b & 0xF];
+					}
+					break;
+				}
+			}
+		};
+
+		stream << "<!-- dmx encoding keyvalues2 1 format model 18 -->\n";
+		for(auto elIdx = 0u; elIdx < elements.size(); ++elIdx) {
+			auto &el = elements[elIdx];
+			stream << "\"" << el.type << "\"\n{\n";
+			stream << "\t\"id\" \"elementid\" \"" << guids[elIdx] << "\"\n";
+			stream << "\t\"name\" \"string\" \"" << el.name << "\"\n";
+			for(auto &attr : el.attributes) {
+				auto *typeName = get_text_type_name(attr.type);
+				if(!attr.isArray) {
+					formatValue(attr, 0);
+					stream << "\t\"" << attr.name << "\" \"" << typeName << "\" \"" << value << "\"\n";
+					continue;
+				}
+				stream << "\t\"" << attr.name << "\" \"" << typeName << "_array\"\n\t[\n";
+				for(auto i = 0u; i < attr.count; ++i) {
+					formatValue(attr, i);
+					stream << "\t\t";
+					if(attr.type == Type::Element)
+						stream << "\"element\" ";
+					stream << "\"" << value << "\"" << ((i + 1 < attr.count) ? ",\n" : "\n");
+				}
+				stream << "\t]\n";
+			}
+			stream << "}\n\n";
+		}
+	}
+};
+
+std::optional<pr_dmx_benchmark::GeneratorSettings> pr_dmx_benchmark::get_preset(const std::string &name)
+{
+	GeneratorSettings settings {};
+	settings.name = name;
+	if(name == "small") {
+		settings.animationSets = 2;
+		settings.channelsPerSet = 16;
+		settings.keysPerLog = 64;
+		settings.meshes = 1;
+		settings.verticesPerMesh = 512;
+		settings.chainDepth = 8;
+	}
+	else if(name == "medium") {
+		settings.animationSets = 8;
+		settings.channelsPerSet = 64;
+		settings.keysPerLog = 512;
+		settings.meshes = 4;
+		settings.verticesPerMesh = 16'384;
+		settings.chainDepth = 64;
+	}
+	else if(name == "large") {
+		settings.animationSets = 16;
+		settings.channelsPerSet = 128;
+		settings.keysPerLog = 2'048;
+		settings.meshes = 8;
+		settings.verticesPerMesh = 131'072;
+		settings.chainDepth = 512;
+	}
+	else if(name == "huge") {
+		settings.animationSets = 32;
+		settings.channelsPerSet = 256;
+		settings.keysPerLog = 2'048;
+		settings.meshes = 16;
+		settings.verticesPerMesh = 262'144;
+		settings.chainDepth = 2'048;
+	}
+	else
+		return {};
+	return settings;
+}
+
+std::vector<std::string> pr_dmx_benchmark::get_preset_names() { return {"small", "medium", "large", "huge"}; }
+
+uint64_t pr_dmx_benchmark::get_settings_hash(const GeneratorSettings &settings)
+{
+	// Has to be incremented whenever the generated content changes
+	constexpr uint32_t GENERATOR_VERSION = 1;
+	// FNV-1a
+	uint64_t hash = 14'695'981'039'346'656'037ull;
+	auto add = [&hash](uint32_t value) {
+		for(auto i = 0u; i < sizeof(value); ++i) {
+			hash ^= (value >> (i * 8)) & 0xFF;
+			hash *= 1'099'511'628'211ull;
+		}
+	};
+	add(GENERATOR_VERSION);
+	add(settings.animationSets);
+	add(settings.channelsPerSet);
+	add(settings.keysPerLog);
+	add(settings.meshes);
+	add(settings.verticesPerMesh);
+	add(settings.chainDepth);
+	add(settings.seed);
+	return hash;
+}
+
+std::optional<pr_dmx_benchmark::Encoding> pr_dmx_benchmark::encoding_from_string(const std::string &str)
+{
+	if(str == "binary")
+		return Encoding::Binary;
+	if(str == "text" || str == "keyvalues2")
+		return Encoding::Text;
+	return {};
+}
+
+const char *pr_dmx_benchmark::encoding_to_string(Encoding encoding) { return (encoding == Encoding::Binary) ? "binary" : "keyvalues2"; }
+
+bool pr_dmx_benchmark::generate(const GeneratorSettings &settings, Encoding encoding, const std::string &path, std::string &outErr)
+{
+	Document doc {settings.seed};
+	build_document(doc, settings);
+
+	std::vector<char> buffer(1 << 20);
+	std::ofstream stream {};
+	stream.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+	stream.open(path, std::ios::binary | std::ios::trunc);
+	if(!stream) {
+		outErr = "Unable to open '" + path + "' for writing!";
+		return false;
+	}
+	if(encoding == Encoding::Binary)
+		write_binary(doc, stream);
+	else
+		write_text(doc, stream);
+	stream.flush();
+	if(!stream) {
+		outErr = "Failed to write '" + path + "'!";
+		return false;
+	}
+	return true;
+}
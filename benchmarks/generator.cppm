@@ -0,0 +1,38 @@
+// SPDX-FileCopyrightText: (c) 2020 Silverlan <opensource@pragma-engine.com>
+// SPDX-License-Identifier: MIT
+
+module;
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+export module pr_dmx_benchmark.generator;
+
+export namespace pr_dmx_benchmark {
+	enum class Encoding : uint8_t { Binary = 0, Text };
+
+	// Shape of a synthetic SFM-like session. All content is derived from 'seed', so the same settings always produce the same file.
+	struct GeneratorSettings {
+		std::string name = "custom";
+		uint32_t animationSets = 2;
+		uint32_t channelsPerSet = 16;
+		uint32_t keysPerLog = 64;
+		uint32_t meshes = 1;
+		uint32_t verticesPerMesh = 512;
+		uint32_t chainDepth = 8; // Length of a linked chain of elements, for deep traversals
+		uint32_t seed = 1;
+	};
+
+	// Presets: "small", "medium", "large", "huge"
+	std::optional<GeneratorSettings> get_preset(const std::string &name);
+	std::vector<std::string> get_preset_names();
+	// Identifies the content generated for the settings (including the version of the generator), e.g. to detect outdated files
+	uint64_t get_settings_hash(const GeneratorSettings &settings);
+
+	std::optional<Encoding> encoding_from_string(const std::string &str);
+	const char *encoding_to_string(Encoding encoding);
+
+	bool generate(const GeneratorSettings &settings, Encoding encoding, const std::string &path, std::string &outErr);
+};
@@ -0,0 +1,107 @@
+-- SPDX-FileCopyrightText: (c) 2020 Silverlan <opensource@pragma-engine.com>
+-- SPDX-License-Identifier: MIT
+
+-- Measures the cost of the dmx Lua bindings (GetElements, GetAttributes, GetValue and __tostring).
+-- Generate the input files with "pr_dmx_benchmark generate" (or "suite") and copy them into the game directory, then run:
+--   lua_exec_cl benchmarks/lua/marshalling.lua <file.dmx> [iterations] [output.json]
+-- Results are printed as JSON and optionally written to the output file.
+
+engine.load_library("pr_dmx")
+
+local args = {...}
+local dmxPath = args[1]
+local iterations = tonumber(args[2] or "5")
+local outputPath = args[3]
+if dmxPath == nil then
+	print("Usage: marshalling.lua <file.dmx> [iterations] [output.json]")
+	return
+end
+
+local function measure(fn)
+	local samples = {}
+	for i = 1, iterations do
+		local t = os.clock()
+		fn()
+		table.insert(samples, (os.clock() - t) * 1000.0)
+	end
+	table.sort(samples)
+	local sum = 0.0
+	for _, v in ipairs(samples) do
+		sum = sum + v
+	end
+	return { min = samples[1], median = samples[math.floor(#samples / 2) + 1], mean = sum / #samples }
+end
+
+local data, err = dmx.load(dmxPath)
+if data == false then
+	print("Unable to load '" .. dmxPath .. "': " .. tostring(err))
+	return
+end
+
+local elements = data:GetElements()
+local numElements = #elements
+local numAttributes = 0
+for _, el in ipairs(elements) do
+	for _, attr in pairs(el:GetAttributes()) do
+		numAttributes = numAttributes + 1
+	end
+end
+
+local results = {}
+results.load_ms = measure(function()
+	dmx.cache_clear()
+	dmx.load(dmxPath)
+end)
+results.get_elements_ms = measure(function()
+	data:GetElements()
+end)
+results.get_attributes_ms = measure(function()
+	for _, el in ipairs(elements) do
+		el:GetAttributes()
+	end
+end)
+results.get_value_ms = measure(function()
+	for _, el in ipairs(elements) do
+		for _, attr in pairs(el:GetAttributes()) do
+			attr:GetValue()
+		end
+	end
+end)
+results.tostring_element_ms = measure(function()
+	for _, el in ipairs(elements) do
+		tostring(el)
+	end
+end)
+
+local function format_timings(name, t)
+	return string.format('"%s": {"min": %f, "median": %f, "mean": %f}', name, t.min, t.median, t.mean)
+end
+local function per_item_ns(t, n)
+	return (n > 0) and (t.median * 1000000.0 / n) or 0.0
+end
+
+local json = "{\n"
+json = json .. string.format('\t"file": "%s", "iterations": %d, "elements": %d, "attributes": %d,\n', dmxPath, iterations, numElements, numAttributes)
+json = json .. "\t" .. format_timings("load_ms", results.load_ms) .. ",\n"
+json = json .. "\t" .. format_timings("get_elements_ms", results.get_elements_ms) .. ",\n"
+json = json .. "\t" .. format_timings("get_attributes_ms", results.get_attributes_ms) .. ",\n"
+json = json .. "\t" .. format_timings("get_value_ms", results.get_value_ms) .. ",\n"
+json = json .. "\t" .. format_timings("tostring_element_ms", results.tostring_element_ms) .. ",\n"
+json = json
+	.. string.format(
+		'\t"get_elements_ns_per_element": %f, "get_attributes_ns_per_element": %f, "get_value_ns_per_attribute": %f, "tostring_ns_per_element": %f\n',
+		per_item_ns(results.get_elements_ms, numElements),
+		per_item_ns(results.get_attributes_ms, numElements),
+		per_item_ns(results.get_value_ms, numAttributes),
+		per_item_ns(results.tostring_element_ms, numElements)
+	)
+json = json .. "}\n"
+print(json)
+
+if outputPath ~= nil then
+	local f = file.open(outputPath, file.OPEN_MODE_WRITE)
+	if f ~= nil then
+		f:WriteString(json)
+		f:Close()
+	end
+end
@@ -0,0 +1,179 @@
+// SPDX-FileCopyrightText: (c) 2020 Silverlan <opensource@pragma-engine.com>
+// SPDX-License-Identifier: MIT
+
+module pragma.modules.dmx;
+
+import :arrays;
+
+size_t pragma::modules::dmx::ArrayLayout::GetComponentSize() const
+{
+	switch(componentType) {
+	case ComponentType::Float:
+		return sizeof(float);
+	case ComponentType::Int32:
+		return sizeof(int32_t);
+	case ComponentType::UInt8:
+		return sizeof(uint8_t);
+	default:
+		break;
+	}
+	return 0;
+}
+
+bool pragma::modules::dmx::is_array_type(source_engine::dmx::AttrType type) { return type >= source_engine::dmx::AttrType::ArrayFirst && type <= source_engine::dmx::AttrType::ArrayLast; }
+
+source_engine::dmx::AttrType pragma::modules::dmx::get_array_entry_type(source_engine::dmx::AttrType arrayType)
+{
+	switch(arrayType) {
+	case source_engine::dmx::AttrType::ElementArray:
+		return source_engine::dmx::AttrType::Element;
+	case source_engine::dmx::AttrType::IntArray:
+		return source_engine::dmx::AttrType::Int;
+	case source_engine::dmx::AttrType::FloatArray:
+		return source_engine::dmx::AttrType::Float;
+	case source_engine::dmx::AttrType::BoolArray:
+		return source_engine::dmx::AttrType::Bool;
+	case source_engine::dmx::AttrType::StringArray:
+		return source_engine::dmx::AttrType::String;
+	case source_engine::dmx::AttrType::BinaryArray:
+		return source_engine::dmx::AttrType::Binary;
+	case source_engine::dmx::AttrType::TimeArray:
+		return source_engine::dmx::AttrType::Time;
+	case source_engine::dmx::AttrType::ObjectIdArray:
+		return source_engine::dmx::AttrType::ObjectId;
+	case source_engine::dmx::AttrType::ColorArray:
+		return source_engine::dmx::AttrType::Color;
+	case source_engine::dmx::AttrType::Vector2Array:
+		return source_engine::dmx::AttrType::Vector2;
+	case source_engine::dmx::AttrType::Vector3Array:
+		return source_engine::dmx::AttrType::Vector3;
+	case source_engine::dmx::AttrType::Vector4Array:
+		return source_engine::dmx::AttrType::Vector4;
+	case source_engine::dmx::AttrType::AngleArray:
+		return source_engine::dmx::AttrType::Angle;
+	case source_engine::dmx::AttrType::QuaternionArray:
+		return source_engine::dmx::AttrType::Quaternion;
+	case source_engine::dmx::AttrType::MatrixArray:
+		return source_engine::dmx::AttrType::Matrix;
+	default:
+		break;
+	}
+	return source_engine::dmx::AttrType::Invalid;
+}
+
+source_engine::dmx::AttrType pragma::modules::dmx::get_array_type(source_engine::dmx::AttrType entryType)
+{
+	for(auto type = pragma::math::to_integral(source_engine::dmx::AttrType::ArrayFirst); type <= pragma::math::to_integral(source_engine::dmx::AttrType::ArrayLast); ++type) {
+		if(get_array_entry_type(static_cast<source_engine::dmx::AttrType>(type)) == entryType)
+			return static_cast<source_engine::dmx::AttrType>(type);
+	}
+	return source_engine::dmx::AttrType::Invalid;
+}
+
+std::optional<pragma::modules::dmx::ArrayLayout> pragma::modules::dmx::get_array_layout(source_engine::dmx::AttrType arrayType)
+{
+	switch(arrayType) {
+	case source_engine::dmx::AttrType::IntArray:
+		return ArrayLayout {ComponentType::Int32, 1};
+	case source_engine::dmx::AttrType::FloatArray:
+	case source_engine::dmx::AttrType::TimeArray:
+		return ArrayLayout {ComponentType::Float, 1};
+	case source_engine::dmx::AttrType::BoolArray:
+		return ArrayLayout {ComponentType::UInt8, 1};
+	case source_engine::dmx::AttrType::ColorArray:
+		return ArrayLayout {ComponentType::UInt8, 4};
+	case source_engine::dmx::AttrType::Vector2Array:
+		return ArrayLayout {ComponentType::Float, 2};
+	case source_engine::dmx::AttrType::Vector3Array:
+	case source_engine::dmx::AttrType::AngleArray:
+		return ArrayLayout {ComponentType::Float, 3};
+	case source_engine::dmx::AttrType::Vector4Array:
+	case source_engine::dmx::AttrType::QuaternionArray:
+		return ArrayLayout {ComponentType::Float, 4};
+	case source_engine::dmx::AttrType::MatrixArray:
+		return ArrayLayout {ComponentType::Float, 16};
+	default:
+		break;
+	}
+	return {};
+}
+
+const std::vector<std::shared_ptr<source_engine::dmx::Attribute>> *pragma::modules::dmx::get_array_values(const source_engine::dmx::Attribute &attr)
+{
+	if(attr.data == nullptr || !is_array_type(attr.type))
+		return nullptr;
+	return static_cast<std::vector<std::shared_ptr<source_engine::dmx::Attribute>> *>(attr.data.get());
+}
+
+// Writes a single array entry to 'out', which must hold at least ArrayLayout::GetEntrySize() bytes.
+// Entries without data are written as zeroes.
+static void write_entry(const source_engine::dmx::Attribute *attr, source_engine::dmx::AttrType arrayType, size_t entrySize, uint8_t *out)
+{
+	if(attr == nullptr || attr->data == nullptr) {
+		std::memset(out, 0, entrySize);
+		return;
+	}
+	auto *data = attr->data.get();
+	switch(arrayType) {
+	case source_engine::dmx::AttrType::BoolArray:
+		*out = *static_cast<bool *>(data) ? 1 : 0;
+		break;
+	case source_engine::dmx::AttrType::AngleArray:
+		{
+			auto &ang = *static_cast<EulerAngles *>(data);
+			std::array<float, 3> v {ang.p, ang.y, ang.r};
+			std::memcpy(out, v.data(), entrySize);
+			break;
+		}
+	case source_engine::dmx::AttrType::QuaternionArray:
+		{
+			auto &rot = *static_cast<Quat *>(data);
+			std::array<float, 4> v {rot.w, rot.x, rot.y, rot.z};
+			std::memcpy(out, v.data(), entrySize);
+			break;
+		}
+	default:
+		// Int, Float, Time, Color, Vector2/3/4 and Matrix are stored with the packed layout already
+		std::memcpy(out, data, entrySize);
+		break;
+	}
+}
+
+void pragma::modules::dmx::pack_array(const std::vector<std::shared_ptr<source_engine::dmx::Attribute>> &values, source_engine::dmx::AttrType arrayType, uint8_t *outData)
+{
+	auto layout = get_array_layout(arrayType);
+	if(!layout.has_value())
+		return;
+	auto entrySize = layout->GetEntrySize();
+	for(auto &val : values) {
+		write_entry(val.get(), arrayType, entrySize, outData);
+		outData += entrySize;
+	}
+}
+
+bool pragma::modules::dmx::pack_value(const source_engine::dmx::Attribute &attr, uint8_t *outData)
+{
+	auto arrayType = get_array_type(attr.type);
+	auto layout = get_array_layout(arrayType);
+	if(!layout.has_value())
+		return false;
+	write_entry(&attr, arrayType, layout->GetEntrySize(), outData);
+	return true;
+}
+
+std::optional<size_t> pragma::modules::dmx::pack_array(const source_engine::dmx::Attribute &attr, pragma::util::DataStream &ds)
+{
+	auto *values = get_array_values(attr);
+	auto layout = get_array_layout(attr.type);
+	if(values == nullptr || !layout.has_value())
+		return {};
+	auto entrySize = layout->GetEntrySize();
+	ds->Reserve(ds->GetOffset() + values->size() * entrySize);
+
+	std::array<uint8_t, sizeof(Mat4)> entry;
+	for(auto &val : *values) {
+		write_entry(val.get(), attr.type, entrySize, entry.data());
+		ds->Write(entry.data(), entrySize);
+	}
+	return values->size();
+}
@@ -0,0 +1,32 @@
+// SPDX-FileCopyrightText: (c) 2020 Silverlan <opensource@pragma-engine.com>
+// SPDX-License-Identifier: MIT
+
+module pragma.modules.dmx;
+
+import :binary_view;
+
+std::optional<pragma::modules::dmx::BinaryView> pragma::modules::dmx::BinaryView::Create(const source_engine::dmx::Attribute &attr)
+{
+	if(attr.type != source_engine::dmx::AttrType::Binary || attr.data == nullptr)
+		return {};
+	// Aliasing constructor: shares the attribute's ownership of the payload
+	std::shared_ptr<const std::vector<uint8_t>> data {attr.data, static_cast<const std::vector<uint8_t> *>(attr.data.get())};
+	return BinaryView {data, 0, data->size()};
+}
+
+pragma::modules::dmx::BinaryView::BinaryView(const std::shared_ptr<const std::vector<uint8_t>> &data, size_t offset, size_t size) : m_data {data}, m_offset {offset}, m_size {size} {}
+
+std::optional<pragma::modules::dmx::BinaryView> pragma::modules::dmx::BinaryView::Slice(size_t offset, size_t size) const
+{
+	if(offset > m_size || m_size - offset < size)
+		return {};
+	return BinaryView {m_data, m_offset + offset, size};
+}
+
+pragma::util::DataStream pragma::modules::dmx::BinaryView::ToDataStream() const
+{
+	pragma::util::DataStream ds(m_size);
+	ds->Write(GetData(), m_size);
+	ds->SetOffset(0);
+	return ds;
+}
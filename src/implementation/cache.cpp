@@ -0,0 +1,218 @@
+// SPDX-FileCopyrightText: (c) 2020 Silverlan <opensource@pragma-engine.com>
+// SPDX-License-Identifier: MIT
+
+module pragma.modules.dmx;
+
+import :cache;
+
+// Rough per-allocation overhead of a std::shared_ptr control block
+static constexpr size_t SHARED_PTR_CONTROL_BLOCK_SIZE = 2 * sizeof(void *);
+
+static size_t get_string_memory_usage(const std::string &str) { return (str.capacity() > 15) ? str.capacity() + 1 : 0; }
+
+size_t pragma::modules::dmx::estimate_memory_usage(const source_engine::dmx::Attribute &attr)
+{
+	auto size = sizeof(attr) + SHARED_PTR_CONTROL_BLOCK_SIZE;
+	if(attr.data == nullptr)
+		return size;
+	size += SHARED_PTR_CONTROL_BLOCK_SIZE;
+	auto *data = attr.data.get();
+	switch(attr.type) {
+	case source_engine::dmx::AttrType::Element:
+		return size + sizeof(std::weak_ptr<source_engine::dmx::Element>);
+	case source_engine::dmx::AttrType::String:
+		{
+			auto &str = *static_cast<std::string *>(data);
+			return size + sizeof(str) + get_string_memory_usage(str);
+		}
+	case source_engine::dmx::AttrType::Int:
+		return size + sizeof(int32_t);
+	case source_engine::dmx::AttrType::Float:
+	case source_engine::dmx::AttrType::Time:
+		return size + sizeof(float);
+	case source_engine::dmx::AttrType::Bool:
+		return size + sizeof(bool);
+	case source_engine::dmx::AttrType::Vector2:
+		return size + sizeof(Vector2);
+	case source_engine::dmx::AttrType::Vector3:
+		return size + sizeof(Vector3);
+	case source_engine::dmx::AttrType::Angle:
+		return size + sizeof(EulerAngles);
+	case source_engine::dmx::AttrType::Vector4:
+		return size + sizeof(Vector4);
+	case source_engine::dmx::AttrType::Quaternion:
+		return size + sizeof(Quat);
+	case source_engine::dmx::AttrType::Matrix:
+		return size + sizeof(Mat4);
+	case source_engine::dmx::AttrType::Color:
+		return size + sizeof(std::array<uint8_t, 4>);
+	case source_engine::dmx::AttrType::Binary:
+		{
+			auto &bin = *static_cast<std::vector<uint8_t> *>(data);
+			return size + sizeof(bin) + bin.capacity();
+		}
+	default:
+		{
+			if(attr.type >= source_engine::dmx::AttrType::ArrayFirst && attr.type <= source_engine::dmx::AttrType::ArrayLast) {
+				auto &vdata = *static_cast<std::vector<std::shared_ptr<source_engine::dmx::Attribute>> *>(data);
+				size += sizeof(vdata) + vdata.capacity() * sizeof(vdata.front());
+				for(auto &subAttr : vdata) {
+					if(subAttr)
+						size += estimate_memory_usage(*subAttr);
+				}
+			}
+			return size;
+		}
+	}
+}
+
+size_t pragma::modules::dmx::estimate_memory_usage(const source_engine::dmx::Element &el)
+{
+	auto size = sizeof(el) + SHARED_PTR_CONTROL_BLOCK_SIZE + get_string_memory_usage(el.name) + get_string_memory_usage(el.type);
+	for(auto &pair : el.attributes) {
+		// Hash map node: key, value and the bucket link
+		size += sizeof(pair) + sizeof(void *) + get_string_memory_usage(pair.first);
+		if(pair.second)
+			size += estimate_memory_usage(*pair.second);
+	}
+	return size;
+}
+
+size_t pragma::modules::dmx::estimate_memory_usage(const source_engine::dmx::FileData &data)
+{
+	auto &elements = const_cast<source_engine::dmx::FileData &>(data).GetElements();
+	auto size = sizeof(data) + elements.capacity() * sizeof(elements.front());
+	for(auto &el : elements) {
+		if(el)
+			size += estimate_memory_usage(*el);
+	}
+	return size;
+}
+
+pragma::modules::dmx::FileCache &pragma::modules::dmx::FileCache::Get()
+{
+	static FileCache cache {};
+	return cache;
+}
+
+std::optional<std::string> pragma::modules::dmx::FileCache::GetKey(const std::string &path)
+{
+	std::string absPath;
+	if(!pragma::fs::find_absolute_path(path, absPath))
+		return {};
+	auto key = std::filesystem::path {absPath}.lexically_normal().generic_string();
+#ifdef _WIN32
+	pragma::string::to_lower(key);
+#endif
+	return key;
+}
+
+pragma::modules::dmx::LoadResult pragma::modules::dmx::FileCache::Load(const std::string &path, const Loader &loader)
+{
+	auto key = GetKey(path);
+	if(!key.has_value())
+		return loader(path);
+	std::error_code ec;
+	auto modificationTime = std::filesystem::last_write_time(*key, ec);
+	auto fileSize = ec ? 0 : std::filesystem::file_size(*key, ec);
+	if(ec)
+		return loader(path);
+
+	{
+		std::scoped_lock lock {m_mutex};
+		auto it = m_lookup.find(*key);
+		if(it != m_lookup.end()) {
+			auto itEntry = it->second;
+			if(itEntry->modificationTime == modificationTime && itEntry->fileSize == fileSize) {
+				m_entries.splice(m_entries.begin(), m_entries, itEntry);
+				++m_hits;
+				return LoadResult {itEntry->data};
+			}
+			Erase(itEntry);
+		}
+		++m_misses;
+		if(m_budget == 0)
+			return loader(path);
+	}
+
+	// Parsing happens outside of the lock; concurrent misses for the same file will parse it more than once
+	auto result = loader(path);
+	if(!result.IsSuccessful())
+		return result;
+	// Walking the graph costs a fraction of parsing it and is only done while the cache is enabled
+	auto memoryUsage = estimate_memory_usage(*result.data);
+
+	std::scoped_lock lock {m_mutex};
+	if(memoryUsage > m_budget)
+		return result;
+	auto it = m_lookup.find(*key);
+	if(it != m_lookup.end())
+		Erase(it->second);
+	m_entries.push_front(Entry {*key, modificationTime, fileSize, result.data, memoryUsage});
+	m_lookup[*key] = m_entries.begin();
+	m_memoryUsage += memoryUsage;
+	Evict();
+	return result;
+}
+
+void pragma::modules::dmx::FileCache::Erase(std::list<Entry>::iterator it)
+{
+	m_memoryUsage -= it->memoryUsage;
+	m_lookup.erase(it->key);
+	m_entries.erase(it);
+}
+
+void pragma::modules::dmx::FileCache::Evict()
+{
+	while(m_memoryUsage > m_budget && !m_entries.empty()) {
+		Erase(std::prev(m_entries.end()));
+		++m_evictions;
+	}
+}
+
+void pragma::modules::dmx::FileCache::Invalidate(const std::string &path)
+{
+	auto key = GetKey(path);
+	if(!key.has_value())
+		return;
+	std::scoped_lock lock {m_mutex};
+	auto it = m_lookup.find(*key);
+	if(it != m_lookup.end())
+		Erase(it->second);
+}
+
+void pragma::modules::dmx::FileCache::Detach(const source_engine::dmx::FileData &data)
+{
+	std::scoped_lock lock {m_mutex};
+	auto it = std::find_if(m_entries.begin(), m_entries.end(), [&data](const Entry &entry) { return entry.data.get() == &data; });
+	if(it != m_entries.end())
+		Erase(it);
+}
+
+void pragma::modules::dmx::FileCache::Clear()
+{
+	std::scoped_lock lock {m_mutex};
+	m_entries.clear();
+	m_lookup.clear();
+	m_memoryUsage = 0;
+}
+
+void pragma::modules::dmx::FileCache::SetBudget(size_t budget)
+{
+	std::scoped_lock lock {m_mutex};
+	m_budget = budget;
+	Evict();
+}
+
+pragma::modules::dmx::FileCache::Stats pragma::modules::dmx::FileCache::GetStats() const
+{
+	std::scoped_lock lock {m_mutex};
+	Stats stats {};
+	stats.entryCount = m_entries.size();
+	stats.memoryUsage = m_memoryUsage;
+	stats.budget = m_budget;
+	stats.hits = m_hits;
+	stats.misses = m_misses;
+	stats.evictions = m_evictions;
+	return stats;
+}
@@ -0,0 +1,130 @@
+// SPDX-FileCopyrightText: (c) 2020 Silverlan <opensource@pragma-engine.com>
+// SPDX-License-Identifier: MIT
+
+module pragma.modules.dmx;
+
+import :data_info;
+
+std::unique_ptr<pragma::modules::dmx::ElementIndex> pragma::modules::dmx::ElementIndex::Build(source_engine::dmx::FileData &data)
+{
+	auto index = std::unique_ptr<ElementIndex> {new ElementIndex {}};
+	auto &elements = data.GetElements();
+	index->m_byGuid.reserve(elements.size());
+	for(auto &el : elements) {
+		if(el == nullptr)
+			continue;
+		index->m_byGuid[el->GetGUIDAsString()] = el;
+		index->m_byType[el->type].push_back(el);
+		index->m_byName[el->name].push_back(el);
+	}
+	return index;
+}
+
+std::shared_ptr<source_engine::dmx::Element> pragma::modules::dmx::ElementIndex::FindByGUID(const std::string &guid) const
+{
+	auto it = m_byGuid.find(guid);
+	return (it != m_byGuid.end()) ? it->second.lock() : nullptr;
+}
+
+const std::vector<std::weak_ptr<source_engine::dmx::Element>> *pragma::modules::dmx::ElementIndex::FindByType(const std::string &type) const
+{
+	auto it = m_byType.find(type);
+	return (it != m_byType.end()) ? &it->second : nullptr;
+}
+
+const std::vector<std::weak_ptr<source_engine::dmx::Element>> *pragma::modules::dmx::ElementIndex::FindByName(const std::string &name) const
+{
+	auto it = m_byName.find(name);
+	return (it != m_byName.end()) ? &it->second : nullptr;
+}
+
+pragma::modules::dmx::DataInfo::DataInfo(const std::shared_ptr<source_engine::dmx::FileData> &data) : m_data {data} {}
+
+const pragma::modules::dmx::ElementIndex &pragma::modules::dmx::DataInfo::GetIndex()
+{
+	std::scoped_lock lock {m_mutex};
+	if(m_index == nullptr) {
+		auto data = m_data.lock();
+		m_index = (data != nullptr) ? ElementIndex::Build(*data) : std::unique_ptr<ElementIndex> {new ElementIndex {}};
+	}
+	return *m_index;
+}
+
+pragma::modules::dmx::ContentStats pragma::modules::dmx::DataInfo::GetContentStats()
+{
+	std::scoped_lock lock {m_mutex};
+	if(!m_contentStats.has_value()) {
+		auto data = m_data.lock();
+		m_contentStats = (data != nullptr) ? ContentStats::Compute(*data) : ContentStats {};
+	}
+	return *m_contentStats;
+}
+
+void pragma::modules::dmx::DataInfo::InvalidateCaches()
+{
+	std::scoped_lock lock {m_mutex};
+	m_index = nullptr;
+	m_contentStats = {};
+}
+
+void pragma::modules::dmx::DataInfo::SetLoadStats(const LoadStats &stats)
+{
+	std::scoped_lock lock {m_mutex};
+	m_loadStats = stats;
+}
+
+std::optional<pragma::modules::dmx::LoadStats> pragma::modules::dmx::DataInfo::GetLoadStats() const
+{
+	std::scoped_lock lock {m_mutex};
+	return m_loadStats;
+}
+
+void pragma::modules::dmx::DataInfo::SetSourcePath(const std::string &path)
+{
+	std::scoped_lock lock {m_mutex};
+	m_sourcePath = path;
+}
+
+std::string pragma::modules::dmx::DataInfo::GetSourcePath() const
+{
+	std::scoped_lock lock {m_mutex};
+	return m_sourcePath;
+}
+
+pragma::modules::dmx::DataRegistry &pragma::modules::dmx::DataRegistry::Get()
+{
+	static DataRegistry registry {};
+	return registry;
+}
+
+void pragma::modules::dmx::DataRegistry::Prune()
+{
+	for(auto it = m_infos.begin(); it != m_infos.end();) {
+		if(it->second->GetData() == nullptr)
+			it = m_infos.erase(it);
+		else
+			++it;
+	}
+}
+
+std::shared_ptr<pragma::modules::dmx::DataInfo> pragma::modules::dmx::DataRegistry::Register(const std::shared_ptr<source_engine::dmx::FileData> &data)
+{
+	std::scoped_lock lock {m_mutex};
+	auto it = m_infos.find(data.get());
+	if(it != m_infos.end() && it->second->GetData() == data)
+		return it->second;
+	Prune();
+	auto info = std::make_shared<DataInfo>(data);
+	m_infos[data.get()] = info;
+	return info;
+}
+
+std::shared_ptr<pragma::modules::dmx::DataInfo> pragma::modules::dmx::DataRegistry::Find(const source_engine::dmx::FileData &data)
+{
+	std::scoped_lock lock {m_mutex};
+	auto it = m_infos.find(&data);
+	// An expired entry may belong to a previous FileData that happened to live at the same address
+	if(it == m_infos.end() || it->second->GetData().get() != &data)
+		return nullptr;
+	return it->second;
+}
@@ -0,0 +1,262 @@
+// SPDX-FileCopyrightText: (c) 2020 Silverlan <opensource@pragma-engine.com>
+// SPDX-License-Identifier: MIT
+
+module pragma.modules.dmx;
+
+import :arrays;
+import :cache;
+import :data_info;
+import :diff;
+import :loader;
+
+static std::shared_ptr<source_engine::dmx::Element> get_element(const source_engine::dmx::Attribute &attr)
+{
+	if(attr.type != source_engine::dmx::AttrType::Element || attr.data == nullptr)
+		return nullptr;
+	return static_cast<std::weak_ptr<source_engine::dmx::Element> *>(attr.data.get())->lock();
+}
+
+static bool values_equal(const source_engine::dmx::Attribute &a, const source_engine::dmx::Attribute &b);
+static bool entries_equal(const std::shared_ptr<source_engine::dmx::Attribute> &a, const std::shared_ptr<source_engine::dmx::Attribute> &b)
+{
+	if(a == nullptr || b == nullptr)
+		return a == b;
+	return values_equal(*a, *b);
+}
+
+static bool values_equal(const source_engine::dmx::Attribute &a, const source_engine::dmx::Attribute &b)
+{
+	if(a.type != b.type)
+		return false;
+	if(a.data == nullptr || b.data == nullptr)
+		return a.data == b.data;
+	switch(a.type) {
+	case source_engine::dmx::AttrType::Element:
+		{
+			// Elements of different files are never identical, compare their identity instead
+			auto elA = get_element(a);
+			auto elB = get_element(b);
+			if(elA == nullptr || elB == nullptr)
+				return elA == elB;
+			return elA->GetGUIDAsString() == elB->GetGUIDAsString();
+		}
+	case source_engine::dmx::AttrType::String:
+		return *static_cast<std::string *>(a.data.get()) == *static_cast<std::string *>(b.data.get());
+	case source_engine::dmx::AttrType::Binary:
+		return *static_cast<std::vector<uint8_t> *>(a.data.get()) == *static_cast<std::vector<uint8_t> *>(b.data.get());
+	default:
+		break;
+	}
+	if(auto *valuesA = pragma::modules::dmx::get_array_values(a)) {
+		auto &valuesB = *pragma::modules::dmx::get_array_values(b);
+		return valuesA->size() == valuesB.size() && std::equal(valuesA->begin(), valuesA->end(), valuesB.begin(), entries_equal);
+	}
+	auto layout = pragma::modules::dmx::get_array_layout(pragma::modules::dmx::get_array_type(a.type));
+	if(!layout.has_value())
+		return false; // No way to compare the values, assume that they have changed
+	std::array<uint8_t, sizeof(Mat4)> packedA;
+	std::array<uint8_t, sizeof(Mat4)> packedB;
+	if(layout->GetEntrySize() > packedA.size() || !pragma::modules::dmx::pack_value(a, packedA.data()) || !pragma::modules::dmx::pack_value(b, packedB.data()))
+		return false;
+	return std::memcmp(packedA.data(), packedB.data(), layout->GetEntrySize()) == 0;
+}
+
+static std::vector<pragma::modules::dmx::ArrayRange> diff_arrays(const std::vector<std::shared_ptr<source_engine::dmx::Attribute>> &a, const std::vector<std::shared_ptr<source_engine::dmx::Attribute>> &b)
+{
+	std::vector<pragma::modules::dmx::ArrayRange> ranges;
+	auto addIndex = [&ranges](uint32_t idx) {
+		if(!ranges.empty() && ranges.back().start + ranges.back().count == idx)
+			++ranges.back().count;
+		else
+			ranges.push_back({idx, 1});
+	};
+	auto n = std::min(a.size(), b.size());
+	for(size_t i = 0; i < n; ++i) {
+		if(!entries_equal(a[i], b[i]))
+			addIndex(static_cast<uint32_t>(i));
+	}
+	// Entries that only exist in one of the arrays
+	auto numExtra = static_cast<uint32_t>(std::max(a.size(), b.size()) - n);
+	if(numExtra > 0) {
+		if(!ranges.empty() && ranges.back().start + ranges.back().count == n)
+			ranges.back().count += numExtra;
+		else
+			ranges.push_back({static_cast<uint32_t>(n), numExtra});
+	}
+	return ranges;
+}
+
+namespace {
+	struct ElementMatch {
+		std::shared_ptr<source_engine::dmx::Element> newElement;
+		std::shared_ptr<source_engine::dmx::Element> oldElement; // nullptr if the element was added
+	};
+	struct ElementMatches {
+		std::vector<ElementMatch> matches; // In the order of the new data
+		std::vector<std::shared_ptr<source_engine::dmx::Element>> removed;
+	};
+};
+
+static ElementMatches match_elements(source_engine::dmx::FileData &oldData, source_engine::dmx::FileData &newData)
+{
+	ElementMatches result {};
+	auto &oldElements = oldData.GetElements();
+	std::unordered_map<std::string, std::shared_ptr<source_engine::dmx::Element>> oldByGuid;
+	oldByGuid.reserve(oldElements.size());
+	for(auto &el : oldElements) {
+		if(el)
+			oldByGuid.emplace(el->GetGUIDAsString(), el);
+	}
+	std::unordered_set<const source_engine::dmx::Element *> matched;
+	auto &newElements = newData.GetElements();
+	result.matches.reserve(newElements.size());
+	for(auto &el : newElements) {
+		if(el == nullptr)
+			continue;
+		ElementMatch match {el, nullptr};
+		auto it = oldByGuid.find(el->GetGUIDAsString());
+		// Each old element can only be matched once, in case the GUID is not unique
+		if(it != oldByGuid.end() && matched.insert(it->second.get()).second)
+			match.oldElement = it->second;
+		result.matches.push_back(std::move(match));
+	}
+	for(auto &el : oldElements) {
+		if(el && !matched.contains(el.get()))
+			result.removed.push_back(el);
+	}
+	return result;
+}
+
+static std::optional<pragma::modules::dmx::ElementChange> diff_elements(const std::shared_ptr<source_engine::dmx::Element> &oldEl, const std::shared_ptr<source_engine::dmx::Element> &newEl)
+{
+	using pragma::modules::dmx::AttributeChange;
+	pragma::modules::dmx::ElementChange change {};
+	change.guid = newEl->GetGUIDAsString();
+	change.oldElement = oldEl;
+	change.newElement = newEl;
+	change.nameChanged = (oldEl->name != newEl->name);
+	change.typeChanged = (oldEl->type != newEl->type);
+	for(auto &[name, newAttr] : newEl->attributes) {
+		auto it = oldEl->attributes.find(name);
+		auto *oldAttr = (it != oldEl->attributes.end()) ? it->second.get() : nullptr;
+		if(oldAttr && newAttr && values_equal(*oldAttr, *newAttr))
+			continue;
+		AttributeChange attrChange {};
+		attrChange.name = name;
+		attrChange.kind = oldAttr ? AttributeChange::Kind::Changed : AttributeChange::Kind::Added;
+		attrChange.oldType = oldAttr ? oldAttr->type : source_engine::dmx::AttrType::Invalid;
+		attrChange.newType = newAttr ? newAttr->type : source_engine::dmx::AttrType::Invalid;
+		auto *oldValues = oldAttr ? pragma::modules::dmx::get_array_values(*oldAttr) : nullptr;
+		auto *newValues = newAttr ? pragma::modules::dmx::get_array_values(*newAttr) : nullptr;
+		attrChange.oldCount = oldValues ? static_cast<uint32_t>(oldValues->size()) : 0;
+		attrChange.newCount = newValues ? static_cast<uint32_t>(newValues->size()) : 0;
+		if(oldValues && newValues && attrChange.oldType == attrChange.newType)
+			attrChange.ranges = diff_arrays(*oldValues, *newValues);
+		change.attributes.push_back(std::move(attrChange));
+	}
+	for(auto &[name, oldAttr] : oldEl->attributes) {
+		if(newEl->attributes.find(name) != newEl->attributes.end())
+			continue;
+		AttributeChange attrChange {};
+		attrChange.name = name;
+		attrChange.kind = AttributeChange::Kind::Removed;
+		attrChange.oldType = oldAttr ? oldAttr->type : source_engine::dmx::AttrType::Invalid;
+		auto *oldValues = oldAttr ? pragma::modules::dmx::get_array_values(*oldAttr) : nullptr;
+		attrChange.oldCount = oldValues ? static_cast<uint32_t>(oldValues->size()) : 0;
+		change.attributes.push_back(std::move(attrChange));
+	}
+	if(!change.nameChanged && !change.typeChanged && change.attributes.empty())
+		return {};
+	std::sort(change.attributes.begin(), change.attributes.end(), [](const AttributeChange &a, const AttributeChange &b) { return a.name < b.name; });
+	return change;
+}
+
+static pragma::modules::dmx::Diff diff_matches(const ElementMatches &matches)
+{
+	pragma::modules::dmx::Diff result {};
+	for(auto &match : matches.matches) {
+		if(match.oldElement == nullptr) {
+			result.added.push_back(match.newElement);
+			continue;
+		}
+		auto change = diff_elements(match.oldElement, match.newElement);
+		if(change.has_value())
+			result.changed.push_back(std::move(*change));
+	}
+	result.removed = matches.removed;
+	return result;
+}
+
+pragma::modules::dmx::Diff pragma::modules::dmx::diff(source_engine::dmx::FileData &oldData, source_engine::dmx::FileData &newData)
+{
+	auto matches = match_elements(oldData, newData);
+	return diff_matches(matches);
+}
+
+// Updates an element of the previous data to the values of the element that replaces it, so handles to it stay valid.
+// Attributes that exist in both keep their identity and share the payload of the new attribute.
+static void patch_element(source_engine::dmx::Element &oldEl, const source_engine::dmx::Element &newEl)
+{
+	oldEl.name = newEl.name;
+	oldEl.type = newEl.type;
+	for(auto it = oldEl.attributes.begin(); it != oldEl.attributes.end();) {
+		if(newEl.attributes.find(it->first) == newEl.attributes.end())
+			it = oldEl.attributes.erase(it);
+		else
+			++it;
+	}
+	for(auto &[name, newAttr] : newEl.attributes) {
+		auto &oldAttr = oldEl.attributes[name];
+		if(oldAttr == nullptr || newAttr == nullptr) {
+			oldAttr = newAttr;
+			continue;
+		}
+		oldAttr->type = newAttr->type;
+		oldAttr->data = newAttr->data;
+	}
+}
+
+std::optional<pragma::modules::dmx::Diff> pragma::modules::dmx::reload(source_engine::dmx::FileData &data, std::string &outErr)
+{
+	auto info = DataRegistry::Get().Find(data);
+	auto path = info ? info->GetSourcePath() : std::string {};
+	if(path.empty()) {
+		outErr = "Data was not loaded from a file path and can not be reloaded";
+		return {};
+	}
+	// 'data' is replaced below, so it must not be handed out by the cache anymore.
+	// The entry for the path is outdated as well, even if it holds a different FileData.
+	FileCache::Get().Detach(data);
+	FileCache::Get().Invalidate(path);
+	auto result = load(path);
+	if(!result.IsSuccessful()) {
+		outErr = result.errorMessage.empty() ? ("Unable to reload '" + path + "'") : result.errorMessage;
+		return {};
+	}
+	auto &newData = *result.data;
+
+	auto matches = match_elements(data, newData);
+	auto changes = diff_matches(matches);
+	for(auto &match : matches.matches) {
+		if(match.oldElement)
+			patch_element(*match.oldElement, *match.newElement);
+	}
+	auto &rootAttr = data.GetRootAttribute();
+	auto &newRootAttr = newData.GetRootAttribute();
+	if(rootAttr && newRootAttr) {
+		rootAttr->type = newRootAttr->type;
+		rootAttr->data = newRootAttr->data;
+	}
+
+	std::optional<LoadStats> loadStats {};
+	if(auto newInfo = DataRegistry::Get().Find(newData))
+		loadStats = newInfo->GetLoadStats();
+	// FileData has no interface for replacing its elements, so the reloaded data takes its place as a whole
+	data = std::move(newData);
+	if(info) {
+		info->InvalidateCaches();
+		if(loadStats.has_value())
+			info->SetLoadStats(*loadStats);
+	}
+	return changes;
+}
@@ -0,0 +1,423 @@
+// SPDX-FileCopyrightText: (c) 2020 Silverlan <opensource@pragma-engine.com>
+// SPDX-License-Identifier: MIT
+
+module pragma.modules.dmx;
+
+import :arrays;
+import :dump;
+import :lazy;
+
+namespace {
+	constexpr size_t FLUSH_SIZE = 64 * 1'024;
+	constexpr std::string_view TABS = "\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t";
+
+	class Dumper {
+	  public:
+		Dumper(const pragma::modules::dmx::DumpOptions &options, const pragma::modules::dmx::DumpSink &sink) : m_options {options}, m_sink {sink} {}
+		void DumpElement(const std::shared_ptr<source_engine::dmx::Element> &root)
+		{
+			BeginElement(root, 0, 0, false);
+			Run();
+		}
+		void DumpAttribute(source_engine::dmx::Attribute &attr)
+		{
+			WriteAttribute({}, attr, 0, 0);
+			Run();
+		}
+		pragma::modules::dmx::DumpResult Finish()
+		{
+			// Unwind whatever is left, so the JSON output stays well-formed even if it was cut short
+			if(IsJson()) {
+				for(auto it = m_frames.rbegin(); it != m_frames.rend(); ++it)
+					Write(it->close);
+				Write("\n");
+			}
+			else if(m_result.truncated)
+				Write("...\n");
+			m_frames.clear();
+			Flush();
+			m_result.bytesWritten = m_bytesWritten;
+			return m_result;
+		}
+	  private:
+		struct Frame {
+			// Element frames iterate over the attributes of 'element', array frames over the entries of 'array'
+			source_engine::dmx::Element *element = nullptr;
+			decltype(source_engine::dmx::Element::attributes)::iterator itAttr {};
+			const std::vector<std::shared_ptr<source_engine::dmx::Attribute>> *array = nullptr;
+			size_t arrayIndex = 0;
+			uint32_t depth = 0;
+			uint32_t indent = 0;
+			bool first = true;
+			std::string_view close; // JSON only
+		};
+
+		bool IsJson() const { return m_options.format == pragma::modules::dmx::DumpOptions::Format::Json; }
+
+		void Run()
+		{
+			while(!m_frames.empty() && !m_stop) {
+				auto &frame = m_frames.back();
+				if(frame.element) {
+					if(frame.itAttr == frame.element->attributes.end()) {
+						if(IsJson())
+							Write(frame.close);
+						m_frames.pop_back();
+						continue;
+					}
+					auto &[name, attr] = *frame.itAttr++;
+					if(attr == nullptr)
+						continue;
+					// 'frame' must not be used after this point, WriteAttribute may push new frames
+					auto indent = frame.indent;
+					auto depth = frame.depth;
+					WriteSeparator(frame);
+					WriteAttribute(name, *attr, indent, depth);
+					continue;
+				}
+				if(frame.arrayIndex == frame.array->size()) {
+					if(IsJson())
+						Write(frame.close);
+					m_frames.pop_back();
+					continue;
+				}
+				auto idx = frame.arrayIndex++;
+				auto &entry = (*frame.array)[idx];
+				auto indent = frame.indent;
+				auto depth = frame.depth;
+				WriteSeparator(frame);
+				auto el = (entry && entry->data) ? static_cast<std::weak_ptr<source_engine::dmx::Element> *>(entry->data.get())->lock() : nullptr;
+				if(!IsJson()) {
+					WriteIndent(indent);
+					Write("[");
+					WriteInt(idx);
+					Write("]: ");
+				}
+				if(el)
+					BeginElement(el, depth + 1, indent, false);
+				else
+					Write(IsJson() ? "null" : "NULL\n");
+			}
+		}
+
+		void WriteSeparator(Frame &frame)
+		{
+			if(IsJson() && !frame.first)
+				Write(",");
+			frame.first = false;
+		}
+
+		// Writes the element header and pushes a frame for its attributes, if it should be expanded.
+		// 'wrapped' is set if the element is the value of an attribute, which has to be closed as well (JSON only).
+		void BeginElement(const std::shared_ptr<source_engine::dmx::Element> &el, uint32_t depth, uint32_t indent, bool wrapped)
+		{
+			auto json = IsJson();
+			auto visited = m_visited.contains(el.get());
+			auto expand = !visited && depth <= m_options.maxDepth && m_result.elementCount < m_options.maxElements;
+			if(!visited && !expand)
+				m_result.truncated = true;
+			if(!expand) {
+				if(json) {
+					Write("{\"ref\":");
+					WriteString(el->GetGUIDAsString());
+					Write(",\"name\":");
+					WriteString(el->name);
+					Write(wrapped ? "}}" : "}");
+					return;
+				}
+				Write(visited ? "-> " : "");
+				Write(el->name);
+				Write(" (");
+				Write(el->type);
+				Write(") [");
+				Write(el->GetGUIDAsString());
+				Write(visited ? "]\n" : "] ...\n");
+				return;
+			}
+			m_visited.insert(el.get());
+			++m_result.elementCount;
+			pragma::modules::dmx::materialize(el);
+			if(json) {
+				Write("{\"name\":");
+				WriteString(el->name);
+				Write(",\"type\":");
+				WriteString(el->type);
+				Write(",\"guid\":");
+				WriteString(el->GetGUIDAsString());
+				Write(",\"attributes\":{");
+			}
+			else {
+				Write(el->name);
+				Write(" (");
+				Write(el->type);
+				Write(", ");
+				WriteInt(el->attributes.size());
+				Write(" attributes)\n");
+			}
+			Frame frame {};
+			frame.element = el.get();
+			frame.itAttr = el->attributes.begin();
+			frame.depth = depth;
+			frame.indent = indent + 1;
+			frame.close = wrapped ? "}}}" : "}}";
+			m_frames.push_back(frame);
+		}
+
+		void WriteAttribute(std::optional<std::string_view> name, source_engine::dmx::Attribute &attr, uint32_t indent, uint32_t depth)
+		{
+			auto json = IsJson();
+			std::string typeName {source_engine::dmx::type_to_string(attr.type)};
+			if(json) {
+				if(name.has_value()) {
+					WriteString(*name);
+					Write(":");
+				}
+				Write("{\"type\":");
+				WriteString(typeName);
+			}
+			else {
+				WriteIndent(indent);
+				if(name.has_value()) {
+					Write(*name);
+					Write(" ");
+				}
+				Write("(");
+				Write(typeName);
+				Write(")");
+			}
+
+			if(attr.data == nullptr) {
+				Write(json ? ",\"value\":null}" : ": NULL\n");
+				return;
+			}
+			if(attr.type == source_engine::dmx::AttrType::Element) {
+				auto el = static_cast<std::weak_ptr<source_engine::dmx::Element> *>(attr.data.get())->lock();
+				if(el == nullptr) {
+					Write(json ? ",\"value\":null}" : ": NULL\n");
+					return;
+				}
+				Write(json ? ",\"value\":" : ": ");
+				BeginElement(el, depth + 1, indent, true);
+				return;
+			}
+			auto *values = pragma::modules::dmx::get_array_values(attr);
+			if(values == nullptr) {
+				Write(json ? ",\"value\":" : ": ");
+				WriteValue(attr);
+				Write(json ? "}" : "\n");
+				return;
+			}
+
+			if(json) {
+				Write(",\"count\":");
+				WriteInt(values->size());
+				Write(",\"value\":[");
+			}
+			else {
+				Write("[");
+				WriteInt(values->size());
+				Write("]");
+			}
+			if(attr.type == source_engine::dmx::AttrType::ElementArray) {
+				if(!json)
+					Write(values->empty() ? "\n" : ":\n");
+				Frame frame {};
+				frame.array = values;
+				frame.depth = depth;
+				frame.indent = indent + 1;
+				frame.close = "]}";
+				m_frames.push_back(frame);
+				return;
+			}
+			if(!json && !values->empty())
+				Write(": ");
+			auto n = std::min<size_t>(values->size(), m_options.maxArrayEntries);
+			for(size_t i = 0; i < n; ++i) {
+				if(i > 0)
+					Write(json ? "," : ", ");
+				auto &val = (*values)[i];
+				if(val)
+					WriteValue(*val);
+				else
+					Write(json ? "null" : "NULL");
+			}
+			if(!json && n < values->size())
+				Write(", ...");
+			Write(json ? "]}" : "\n");
+		}
+
+		// Writes a single non-element value
+		void WriteValue(source_engine::dmx::Attribute &attr)
+		{
+			auto json = IsJson();
+			if(attr.data == nullptr) {
+				Write(json ? "null" : "NULL");
+				return;
+			}
+			switch(attr.type) {
+			case source_engine::dmx::AttrType::String:
+				WriteString(*static_cast<std::string *>(attr.data.get()));
+				return;
+			case source_engine::dmx::AttrType::Bool:
+				Write(*static_cast<bool *>(attr.data.get()) ? "true" : "false");
+				return;
+			case source_engine::dmx::AttrType::Binary:
+				{
+					auto size = static_cast<std::vector<uint8_t> *>(attr.data.get())->size();
+					Write(json ? "{\"size\":" : "<");
+					WriteInt(size);
+					Write(json ? "}" : " bytes>");
+					return;
+				}
+			default:
+				break;
+			}
+			auto layout = pragma::modules::dmx::get_array_layout(pragma::modules::dmx::get_array_type(attr.type));
+			std::array<uint8_t, sizeof(float) * 16> packed;
+			if(!layout.has_value() || layout->GetEntrySize() > packed.size() || !pragma::modules::dmx::pack_value(attr, packed.data())) {
+				Write(json ? "null" : "?");
+				return;
+			}
+			if(layout->componentCount > 1)
+				Write(json ? "[" : "");
+			for(auto c = 0u; c < layout->componentCount; ++c) {
+				if(c > 0)
+					Write(json ? "," : " ");
+				auto *p = packed.data() + c * layout->GetComponentSize();
+				switch(layout->componentType) {
+				case pragma::modules::dmx::ComponentType::Float:
+					{
+						float v;
+						std::memcpy(&v, p, sizeof(v));
+						WriteFloat(v);
+						break;
+					}
+				case pragma::modules::dmx::ComponentType::Int32:
+					{
+						int32_t v;
+						std::memcpy(&v, p, sizeof(v));
+						WriteInt(v);
+						break;
+					}
+				case pragma::modules::dmx::ComponentType::UInt8:
+					WriteInt(*p);
+					break;
+				default:
+					break;
+				}
+			}
+			if(layout->componentCount > 1)
+				Write(json ? "]" : "");
+		}
+
+		// The byte limit is only checked between attributes and array entries, so the output never ends in the middle of a value
+		void Write(std::string_view str)
+		{
+			if(str.empty())
+				return;
+			m_buffer.append(str);
+			m_bytesWritten += str.size();
+			if(m_buffer.size() >= FLUSH_SIZE)
+				Flush();
+			if(m_bytesWritten >= m_options.maxBytes && !m_stop) {
+				m_stop = true;
+				m_result.truncated = true;
+			}
+		}
+		void WriteIndent(uint32_t indent)
+		{
+			if(IsJson())
+				return;
+			while(indent > 0) {
+				auto n = std::min<size_t>(indent, TABS.size());
+				Write(TABS.substr(0, n));
+				indent -= static_cast<uint32_t>(n);
+			}
+		}
+		void WriteInt(int64_t value)
+		{
+			std::array<char, 24> buf;
+			auto res = std::to_chars(buf.data(), buf.data() + buf.size(), value);
+			Write({buf.data(), static_cast<size_t>(res.ptr - buf.data())});
+		}
+		void WriteFloat(float value)
+		{
+			if(!std::isfinite(value)) {
+				// Not representable in JSON
+				Write(IsJson() ? "null" : (std::isnan(value) ? "nan" : (value < 0.f ? "-inf" : "inf")));
+				return;
+			}
+			std::array<char, 32> buf;
+			auto res = std::to_chars(buf.data(), buf.data() + buf.size(), value);
+			Write({buf.data(), static_cast<size_t>(res.ptr - buf.data())});
+		}
+		void WriteString(std::string_view str)
+		{
+			Write("\"");
+			size_t start = 0;
+			for(size_t i = 0; i < str.size(); ++i) {
+				auto c = static_cast<unsigned char>(str[i]);
+				if(c != '"' && c != '\\' && c >= 0x20)
+					continue;
+				Write(str.substr(start, i - start));
+				start = i + 1;
+				switch(c) {
+				case '"':
+					Write("\\\"");
+					break;
+				case '\\':
+					Write("\\\\");
+					break;
+				case '\n':
+					Write("\\n");
+					break;
+				case '\r':
+					Write("\\r");
+					break;
+				case '\t':
+					Write("\\t");
+					break;
+				default:
+					{
+						constexpr std::string_view hex = "0123456789abcdef";
+						std::array<char, 6> esc {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xf]};
+						Write({esc.data(), esc.size()});
+						break;
+					}
+				}
+			}
+			Write(str.substr(start));
+			Write("\"");
+		}
+		void Flush()
+		{
+			if(m_buffer.empty())
+				return;
+			m_sink(m_buffer);
+			m_buffer.clear();
+		}
+
+		const pragma::modules::dmx::DumpOptions &m_options;
+		const pragma::modules::dmx::DumpSink &m_sink;
+		std::unordered_set<const source_engine::dmx::Element *> m_visited;
+		std::vector<Frame> m_frames;
+		std::string m_buffer;
+		uint64_t m_bytesWritten = 0;
+		bool m_stop = false;
+		pragma::modules::dmx::DumpResult m_result {};
+	};
+};
+
+pragma::modules::dmx::DumpResult pragma::modules::dmx::dump(const std::shared_ptr<source_engine::dmx::Element> &root, const DumpOptions &options, const DumpSink &sink)
+{
+	Dumper dumper {options, sink};
+	dumper.DumpElement(root);
+	return dumper.Finish();
+}
+
+pragma::modules::dmx::DumpResult pragma::modules::dmx::dump(source_engine::dmx::Attribute &attr, const DumpOptions &options, const DumpSink &sink)
+{
+	Dumper dumper {options, sink};
+	dumper.DumpAttribute(attr);
+	return dumper.Finish();
+}
@@ -0,0 +1,261 @@
+// SPDX-FileCopyrightText: (c) 2020 Silverlan <opensource@pragma-engine.com>
+// SPDX-License-Identifier: MIT
+
+module pragma.modules.dmx;
+
+import :arrays;
+import :frozen;
+
+pragma::modules::dmx::FrozenDocument::StringId pragma::modules::dmx::FrozenDocument::Intern(const std::string &str)
+{
+	auto it = m_stringIds.find(str);
+	if(it != m_stringIds.end())
+		return it->second;
+	auto id = static_cast<StringId>(m_strings.size());
+	it = m_stringIds.insert({str, id}).first;
+	m_strings.push_back(&it->first);
+	return id;
+}
+
+std::optional<pragma::modules::dmx::FrozenDocument::StringId> pragma::modules::dmx::FrozenDocument::FindString(const std::string &str) const
+{
+	auto it = m_stringIds.find(str);
+	if(it == m_stringIds.end())
+		return {};
+	return it->second;
+}
+
+template<typename T>
+static uint8_t *append(std::vector<T> &buffer, size_t componentCount, uint32_t &outOffset)
+{
+	outOffset = static_cast<uint32_t>(buffer.size());
+	buffer.resize(buffer.size() + componentCount);
+	return reinterpret_cast<uint8_t *>(buffer.data() + outOffset);
+}
+
+std::shared_ptr<pragma::modules::dmx::FrozenDocument> pragma::modules::dmx::FrozenDocument::Create(source_engine::dmx::FileData &data)
+{
+	auto doc = std::shared_ptr<FrozenDocument> {new FrozenDocument {}};
+	auto &elements = data.GetElements();
+
+	// Elements that are only reachable through attributes are appended to the list while it is being processed
+	std::vector<source_engine::dmx::Element *> elementList;
+	std::unordered_map<const source_engine::dmx::Element *, Index> elementIndices;
+	elementList.reserve(elements.size());
+	elementIndices.reserve(elements.size());
+	auto getElementIndex = [&](const source_engine::dmx::Attribute &attr) -> Index {
+		if(attr.data == nullptr)
+			return INVALID_INDEX;
+		auto el = static_cast<std::weak_ptr<source_engine::dmx::Element> *>(attr.data.get())->lock();
+		if(el == nullptr)
+			return INVALID_INDEX;
+		auto it = elementIndices.find(el.get());
+		if(it != elementIndices.end())
+			return it->second;
+		auto idx = static_cast<Index>(elementList.size());
+		elementList.push_back(el.get());
+		elementIndices[el.get()] = idx;
+		return idx;
+	};
+	for(auto &el : elements) {
+		if(el == nullptr || elementIndices.find(el.get()) != elementIndices.end())
+			continue;
+		elementIndices[el.get()] = static_cast<Index>(elementList.size());
+		elementList.push_back(el.get());
+	}
+
+	auto writeAttribute = [&](StringId name, const source_engine::dmx::Attribute &attr) {
+		AttributeRecord rec {name, attr.type, INVALID_INDEX, 0};
+		if(attr.data == nullptr) {
+			doc->m_attributes.push_back(rec);
+			return;
+		}
+		if(is_array_type(attr.type)) {
+			auto &values = *get_array_values(attr);
+			rec.count = static_cast<uint32_t>(values.size());
+			switch(attr.type) {
+			case source_engine::dmx::AttrType::ElementArray:
+				rec.payload = static_cast<uint32_t>(doc->m_elementRefs.size());
+				for(auto &val : values)
+					doc->m_elementRefs.push_back(val ? getElementIndex(*val) : INVALID_INDEX);
+				break;
+			case source_engine::dmx::AttrType::StringArray:
+				rec.payload = static_cast<uint32_t>(doc->m_stringRefs.size());
+				for(auto &val : values)
+					doc->m_stringRefs.push_back((val && val->data) ? doc->Intern(*static_cast<std::string *>(val->data.get())) : doc->Intern(""));
+				break;
+			case source_engine::dmx::AttrType::BinaryArray:
+				rec.payload = static_cast<uint32_t>(doc->m_binaryRanges.size());
+				for(auto &val : values) {
+					BinaryRange range {doc->m_binaryData.size(), 0};
+					if(val && val->data) {
+						auto &bin = *static_cast<std::vector<uint8_t> *>(val->data.get());
+						range.size = bin.size();
+						doc->m_binaryData.insert(doc->m_binaryData.end(), bin.begin(), bin.end());
+					}
+					doc->m_binaryRanges.push_back(range);
+				}
+				break;
+			default:
+				{
+					auto layout = get_array_layout(attr.type);
+					if(!layout.has_value()) {
+						rec.count = 0;
+						break;
+					}
+					auto n = values.size() * layout->componentCount;
+					uint8_t *out = nullptr;
+					switch(layout->componentType) {
+					case ComponentType::Float:
+						out = append(doc->m_floats, n, rec.payload);
+						break;
+					case ComponentType::Int32:
+						out = append(doc->m_ints, n, rec.payload);
+						break;
+					case ComponentType::UInt8:
+						out = append(doc->m_bytes, n, rec.payload);
+						break;
+					default:
+						break;
+					}
+					if(out)
+						pack_array(values, attr.type, out);
+					break;
+				}
+			}
+			doc->m_attributes.push_back(rec);
+			return;
+		}
+
+		switch(attr.type) {
+		case source_engine::dmx::AttrType::Element:
+			rec.payload = getElementIndex(attr);
+			break;
+		case source_engine::dmx::AttrType::String:
+			rec.payload = doc->Intern(*static_cast<std::string *>(attr.data.get()));
+			break;
+		case source_engine::dmx::AttrType::Binary:
+			{
+				auto &bin = *static_cast<std::vector<uint8_t> *>(attr.data.get());
+				rec.payload = static_cast<uint32_t>(doc->m_binaryRanges.size());
+				doc->m_binaryRanges.push_back({doc->m_binaryData.size(), bin.size()});
+				doc->m_binaryData.insert(doc->m_binaryData.end(), bin.begin(), bin.end());
+				break;
+			}
+		default:
+			{
+				auto layout = get_array_layout(get_array_type(attr.type));
+				if(!layout.has_value())
+					break;
+				uint8_t *out = nullptr;
+				switch(layout->componentType) {
+				case ComponentType::Float:
+					out = append(doc->m_floats, layout->componentCount, rec.payload);
+					break;
+				case ComponentType::Int32:
+					out = append(doc->m_ints, layout->componentCount, rec.payload);
+					break;
+				case ComponentType::UInt8:
+					out = append(doc->m_bytes, layout->componentCount, rec.payload);
+					break;
+				default:
+					break;
+				}
+				if(out)
+					pack_value(attr, out);
+				break;
+			}
+		}
+		doc->m_attributes.push_back(rec);
+	};
+
+	auto &rootAttr = data.GetRootAttribute();
+	if(rootAttr) {
+		doc->m_rootAttribute = static_cast<Index>(doc->m_attributes.size());
+		writeAttribute(doc->Intern(""), *rootAttr);
+	}
+
+	std::vector<std::pair<StringId, const source_engine::dmx::Attribute *>> sortedAttrs;
+	for(Index i = 0; i < elementList.size(); ++i) {
+		auto &el = *elementList[i];
+		ElementRecord rec {doc->Intern(el.name), doc->Intern(el.type), doc->Intern(el.GetGUIDAsString()), static_cast<Index>(doc->m_attributes.size()), static_cast<uint32_t>(el.attributes.size())};
+		doc->m_elements.push_back(rec);
+
+		sortedAttrs.clear();
+		for(auto &pair : el.attributes)
+			sortedAttrs.push_back({doc->Intern(pair.first), pair.second.get()});
+		std::sort(sortedAttrs.begin(), sortedAttrs.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+		for(auto &[name, attr] : sortedAttrs) {
+			if(attr)
+				writeAttribute(name, *attr);
+			else
+				doc->m_attributes.push_back({name, source_engine::dmx::AttrType::None, INVALID_INDEX, 0});
+		}
+	}
+
+	doc->m_elements.shrink_to_fit();
+	doc->m_attributes.shrink_to_fit();
+	doc->m_floats.shrink_to_fit();
+	doc->m_ints.shrink_to_fit();
+	doc->m_bytes.shrink_to_fit();
+	doc->m_elementRefs.shrink_to_fit();
+	doc->m_stringRefs.shrink_to_fit();
+	doc->m_binaryRanges.shrink_to_fit();
+	doc->m_binaryData.shrink_to_fit();
+	return doc;
+}
+
+pragma::modules::dmx::FrozenDocument::Index pragma::modules::dmx::FrozenDocument::FindAttribute(Index elementIdx, const std::string &name) const
+{
+	auto id = FindString(name);
+	if(!id.has_value())
+		return INVALID_INDEX;
+	auto &el = m_elements[elementIdx];
+	auto begin = m_attributes.begin() + el.firstAttribute;
+	auto end = begin + el.attributeCount;
+	auto it = std::lower_bound(begin, end, *id, [](const AttributeRecord &rec, StringId id) { return rec.name < id; });
+	if(it == end || it->name != *id)
+		return INVALID_INDEX;
+	return static_cast<Index>(it - m_attributes.begin());
+}
+
+pragma::modules::dmx::FrozenDocument::Index pragma::modules::dmx::FrozenDocument::GetReferencedElement(Index attrIdx) const
+{
+	auto &attr = m_attributes[attrIdx];
+	if(attr.type != source_engine::dmx::AttrType::Element)
+		return INVALID_INDEX;
+	return attr.payload;
+}
+
+size_t pragma::modules::dmx::FrozenDocument::GetMemoryUsage() const
+{
+	auto size = sizeof(*this);
+	for(auto &pair : m_stringIds)
+		size += sizeof(pair) + sizeof(void *) + pair.first.capacity();
+	size += m_strings.capacity() * sizeof(m_strings.front());
+	size += m_elements.capacity() * sizeof(ElementRecord);
+	size += m_attributes.capacity() * sizeof(AttributeRecord);
+	size += m_floats.capacity() * sizeof(float);
+	size += m_ints.capacity() * sizeof(int32_t);
+	size += m_bytes.capacity();
+	size += m_elementRefs.capacity() * sizeof(Index);
+	size += m_stringRefs.capacity() * sizeof(StringId);
+	size += m_binaryRanges.capacity() * sizeof(BinaryRange);
+	size += m_binaryData.capacity();
+	return size;
+}
+
+source_engine::dmx::AttrType pragma::modules::dmx::FrozenAttribute::GetType() const
+{
+	auto type = document->GetAttribute(index).type;
+	return (arrayIndex >= 0) ? get_array_entry_type(type) : type;
+}
+
+uint32_t pragma::modules::dmx::FrozenAttribute::GetPayload() const
+{
+	auto &rec = document->GetAttribute(index);
+	if(arrayIndex < 0)
+		return rec.payload;
+	auto layout = get_array_layout(rec.type);
+	return rec.payload + static_cast<uint32_t>(arrayIndex) * (layout.has_value() ? layout->componentCount : 1);
+}
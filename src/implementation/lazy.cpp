@@ -0,0 +1,447 @@
+// SPDX-FileCopyrightText: (c) 2020 Silverlan <opensource@pragma-engine.com>
+// SPDX-License-Identifier: MIT
+
+module pragma.modules.dmx;
+
+import :arrays;
+import :lazy;
+import :mapped_file;
+import :stats;
+
+namespace {
+	// Shells of a LazyDocument are created with this deleter, which also carries their decode state.
+	// materialize retrieves it with std::get_deleter, so no global lookup is required to recognize them.
+	struct ShellDeleter {
+		struct State {
+			std::weak_ptr<pragma::modules::dmx::LazyDocument> document;
+			uint32_t index = 0;
+			std::atomic<bool> decoded = false;
+		};
+		std::unique_ptr<State> state;
+		void operator()(source_engine::dmx::Element *el) const { delete el; }
+	};
+};
+
+// Binary type ids, array types are the entry type + ARRAY_TYPE_OFFSET
+static constexpr uint8_t ARRAY_TYPE_OFFSET = 14;
+static constexpr int32_t ELEMENT_INDEX_NULL = -1;
+static constexpr int32_t ELEMENT_INDEX_EXTERNAL = -2;
+static constexpr float TIME_TICKS_PER_SECOND = 10'000.f;
+
+static std::optional<source_engine::dmx::AttrType> get_attribute_type(uint8_t type)
+{
+	switch(type) {
+	case 1:
+		return source_engine::dmx::AttrType::Element;
+	case 2:
+		return source_engine::dmx::AttrType::Int;
+	case 3:
+		return source_engine::dmx::AttrType::Float;
+	case 4:
+		return source_engine::dmx::AttrType::Bool;
+	case 5:
+		return source_engine::dmx::AttrType::String;
+	case 6:
+		return source_engine::dmx::AttrType::Binary;
+	case 7:
+		return source_engine::dmx::AttrType::Time;
+	case 8:
+		return source_engine::dmx::AttrType::Color;
+	case 9:
+		return source_engine::dmx::AttrType::Vector2;
+	case 10:
+		return source_engine::dmx::AttrType::Vector3;
+	case 11:
+		return source_engine::dmx::AttrType::Vector4;
+	case 12:
+		return source_engine::dmx::AttrType::Angle;
+	case 13:
+		return source_engine::dmx::AttrType::Quaternion;
+	case 14:
+		return source_engine::dmx::AttrType::Matrix;
+	default:
+		break;
+	}
+	return {};
+}
+
+// Size of a value of the specified binary type, or 0 if the size depends on the value
+static size_t get_value_size(uint8_t type)
+{
+	switch(type) {
+	case 2:
+	case 3:
+	case 7:
+	case 8:
+		return 4;
+	case 4:
+		return 1;
+	case 9:
+		return 8;
+	case 10:
+	case 12:
+		return 12;
+	case 11:
+	case 13:
+		return 16;
+	case 14:
+		return 64;
+	default:
+		break;
+	}
+	return 0;
+}
+
+class pragma::modules::dmx::LazyDocument::Reader {
+  public:
+	Reader(const uint8_t *data, size_t size, size_t offset) : m_data {data}, m_size {size}, m_offset {offset} {}
+	template<typename T>
+	bool Read(T &outValue)
+	{
+		if(m_size - m_offset < sizeof(T))
+			return false;
+		std::memcpy(&outValue, m_data + m_offset, sizeof(T));
+		m_offset += sizeof(T);
+		return true;
+	}
+	// Returns a pointer to the next 'size' bytes and skips them
+	const uint8_t *Consume(uint64_t size)
+	{
+		if(m_size - m_offset < size)
+			return nullptr;
+		auto *p = m_data + m_offset;
+		m_offset += size;
+		return p;
+	}
+	bool ReadString(std::string_view &outStr)
+	{
+		auto *start = m_data + m_offset;
+		auto *end = static_cast<const uint8_t *>(std::memchr(start, '\0', m_size - m_offset));
+		if(end == nullptr)
+			return false;
+		outStr = {reinterpret_cast<const char *>(start), static_cast<size_t>(end - start)};
+		m_offset += outStr.size() + 1;
+		return true;
+	}
+	size_t GetOffset() const { return m_offset; }
+	size_t GetRemainingSize() const { return m_size - m_offset; }
+  private:
+	const uint8_t *m_data;
+	size_t m_size;
+	size_t m_offset;
+};
+
+std::shared_ptr<pragma::modules::dmx::LazyDocument> pragma::modules::dmx::LazyDocument::Open(const std::string &path, std::string &outErr)
+{
+	std::string absPath;
+	if(!pragma::fs::find_absolute_path(path, absPath)) {
+		outErr = "Unable to locate file '" + path + "'!";
+		return nullptr;
+	}
+	auto mf = MappedFile::Open(absPath, outErr);
+	if(mf == nullptr)
+		return nullptr;
+	auto doc = std::shared_ptr<LazyDocument> {new LazyDocument {}};
+	auto &stats = doc->m_loadStats;
+	auto t = std::chrono::steady_clock::now();
+	ufile::MemoryFile f {const_cast<uint8_t *>(mf->GetData()), mf->GetSize()};
+	if(!read_header(f, stats) || stats.encoding != "binary" || stats.encodingVersion != 5) {
+		outErr = "Only binary DMX files of encoding version 5 can be loaded lazily, use dmx.load instead!";
+		return nullptr;
+	}
+	auto *headerEnd = static_cast<const uint8_t *>(std::memchr(mf->GetData(), '\0', mf->GetSize()));
+	if(headerEnd == nullptr) {
+		outErr = "Unterminated DMX header!";
+		return nullptr;
+	}
+	stats.headerTimeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t).count();
+	t = std::chrono::steady_clock::now();
+
+	Reader reader {mf->GetData(), mf->GetSize(), static_cast<size_t>(headerEnd - mf->GetData()) + 1};
+	// Every string takes at least one byte and every element record 24 bytes, which bounds the counts
+	// before anything is allocated for them
+	int32_t stringCount;
+	if(!reader.Read(stringCount) || stringCount < 0 || static_cast<size_t>(stringCount) > reader.GetRemainingSize()) {
+		outErr = "Invalid string table!";
+		return nullptr;
+	}
+	doc->m_strings.resize(stringCount);
+	for(auto &str : doc->m_strings) {
+		if(!reader.ReadString(str)) {
+			outErr = "Invalid string table!";
+			return nullptr;
+		}
+	}
+	int32_t elementCount;
+	if(!reader.Read(elementCount) || elementCount < 0 || static_cast<size_t>(elementCount) > reader.GetRemainingSize() / (sizeof(int32_t) * 2 + 16)) {
+		outErr = "Invalid element table!";
+		return nullptr;
+	}
+	doc->m_elementRecords.resize(elementCount);
+	for(auto &rec : doc->m_elementRecords) {
+		int32_t type = -1;
+		int32_t name = -1;
+		reader.Read(type);
+		reader.Read(name);
+		reader.Read(rec.guid);
+		if(type < 0 || name < 0 || type >= stringCount || name >= stringCount) {
+			outErr = "Invalid element table!";
+			return nullptr;
+		}
+		rec.type = static_cast<uint32_t>(type);
+		rec.name = static_cast<uint32_t>(name);
+	}
+	doc->m_elements.resize(elementCount);
+
+	// Validates the attribute data of all elements once, so that decoding an element later on can seek
+	// straight to its attributes
+	doc->m_attributeOffsets.resize(elementCount);
+	for(auto i = decltype(elementCount) {0}; i < elementCount; ++i) {
+		doc->m_attributeOffsets[i] = reader.GetOffset();
+		if(!doc->ReadAttributes(reader, nullptr)) {
+			outErr = "Invalid attribute data of element " + std::to_string(i) + " at offset " + std::to_string(doc->m_attributeOffsets[i]) + "!";
+			return nullptr;
+		}
+	}
+	doc->m_file = std::move(mf);
+	stats.bytesRead = reader.GetOffset();
+	stats.parseTimeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t).count();
+
+	if(elementCount > 0) {
+		auto root = std::make_shared<source_engine::dmx::Attribute>();
+		root->type = source_engine::dmx::AttrType::Element;
+		root->data = std::make_shared<std::weak_ptr<source_engine::dmx::Element>>(doc->GetElement(0));
+		doc->m_rootAttribute = root;
+	}
+	return doc;
+}
+
+std::shared_ptr<source_engine::dmx::Element> pragma::modules::dmx::LazyDocument::GetElement(uint32_t idx)
+{
+	if(idx >= m_elements.size())
+		return nullptr;
+	std::scoped_lock lock {m_mutex};
+	return GetShell(idx);
+}
+
+// Must be called with m_mutex held
+std::shared_ptr<source_engine::dmx::Element> pragma::modules::dmx::LazyDocument::GetShell(uint32_t idx)
+{
+	auto &el = m_elements[idx];
+	if(el != nullptr)
+		return el;
+	auto &rec = m_elementRecords[idx];
+	ShellDeleter deleter {std::make_unique<ShellDeleter::State>()};
+	deleter.state->document = weak_from_this();
+	deleter.state->index = idx;
+	el = std::shared_ptr<source_engine::dmx::Element> {new source_engine::dmx::Element {}, std::move(deleter)};
+	el->type = m_strings[rec.type];
+	el->name = m_strings[rec.name];
+	el->GUID = rec.guid;
+	return el;
+}
+
+void pragma::modules::dmx::LazyDocument::DecodeAttributes(uint32_t idx, source_engine::dmx::Element &el, std::atomic<bool> &decoded)
+{
+	std::scoped_lock lock {m_mutex};
+	// Another thread may have decoded the element while this one was waiting for the lock
+	if(decoded.load(std::memory_order_relaxed))
+		return;
+	Reader reader {m_file->GetData(), m_file->GetSize(), m_attributeOffsets[idx]};
+	if(!ReadAttributes(reader, &el)) {
+		el.attributes.clear();
+		return;
+	}
+	++m_decodedCount;
+	decoded.store(true, std::memory_order_release);
+}
+
+// Reads the attribute block of an element. If 'outEl' is nullptr, the values are only validated and skipped.
+bool pragma::modules::dmx::LazyDocument::ReadAttributes(Reader &reader, source_engine::dmx::Element *outEl)
+{
+	int32_t count;
+	if(!reader.Read(count) || count < 0)
+		return false;
+	for(auto i = decltype(count) {0}; i < count; ++i) {
+		int32_t name;
+		uint8_t type;
+		if(!reader.Read(name) || !reader.Read(type) || name < 0 || static_cast<size_t>(name) >= m_strings.size())
+			return false;
+		std::shared_ptr<source_engine::dmx::Attribute> attr = nullptr;
+		if(outEl != nullptr)
+			attr = std::make_shared<source_engine::dmx::Attribute>();
+		auto success = (type > ARRAY_TYPE_OFFSET) ? ReadArray(reader, type - ARRAY_TYPE_OFFSET, attr.get()) : ReadValue(reader, type, false, attr.get());
+		if(!success)
+			return false;
+		if(outEl != nullptr)
+			outEl->attributes[std::string {m_strings[name]}] = attr;
+	}
+	return true;
+}
+
+// Strings are stored in the string table, except for the entries of string arrays
+bool pragma::modules::dmx::LazyDocument::ReadValue(Reader &reader, uint8_t type, bool inArray, source_engine::dmx::Attribute *outAttr)
+{
+	auto attrType = get_attribute_type(type);
+	if(!attrType.has_value())
+		return false;
+	switch(*attrType) {
+	case source_engine::dmx::AttrType::Element:
+		{
+			int32_t idx;
+			if(!reader.Read(idx))
+				return false;
+			std::shared_ptr<source_engine::dmx::Element> el = nullptr;
+			if(idx == ELEMENT_INDEX_EXTERNAL) {
+				// Elements from other files are identified by their GUID and cannot be resolved
+				std::string_view guid;
+				if(!reader.ReadString(guid))
+					return false;
+			}
+			else if(idx != ELEMENT_INDEX_NULL) {
+				if(idx < 0 || static_cast<size_t>(idx) >= m_elements.size())
+					return false;
+				if(outAttr != nullptr)
+					el = GetShell(idx);
+			}
+			if(outAttr != nullptr)
+				outAttr->data = std::make_shared<std::weak_ptr<source_engine::dmx::Element>>(el);
+			break;
+		}
+	case source_engine::dmx::AttrType::String:
+		{
+			std::string_view str;
+			if(inArray) {
+				if(!reader.ReadString(str))
+					return false;
+			}
+			else {
+				int32_t idx;
+				if(!reader.Read(idx) || idx < 0 || static_cast<size_t>(idx) >= m_strings.size())
+					return false;
+				str = m_strings[idx];
+			}
+			if(outAttr != nullptr)
+				outAttr->data = std::make_shared<std::string>(str);
+			break;
+		}
+	case source_engine::dmx::AttrType::Binary:
+		{
+			int32_t size;
+			if(!reader.Read(size) || size < 0)
+				return false;
+			auto *p = reader.Consume(size);
+			if(p == nullptr)
+				return false;
+			if(outAttr != nullptr)
+				outAttr->data = std::make_shared<std::vector<uint8_t>>(p, p + size);
+			break;
+		}
+	default:
+		{
+			auto *p = reader.Consume(get_value_size(type));
+			if(p == nullptr)
+				return false;
+			if(outAttr == nullptr)
+				break;
+			std::array<float, 16> v;
+			std::memcpy(v.data(), p, get_value_size(type));
+			switch(*attrType) {
+			case source_engine::dmx::AttrType::Int:
+				{
+					int32_t i;
+					std::memcpy(&i, p, sizeof(i));
+					outAttr->data = std::make_shared<int32_t>(i);
+					break;
+				}
+			case source_engine::dmx::AttrType::Float:
+				outAttr->data = std::make_shared<float>(v[0]);
+				break;
+			case source_engine::dmx::AttrType::Bool:
+				outAttr->data = std::make_shared<bool>(*p != 0);
+				break;
+			case source_engine::dmx::AttrType::Time:
+				{
+					int32_t ticks;
+					std::memcpy(&ticks, p, sizeof(ticks));
+					outAttr->data = std::make_shared<float>(ticks / TIME_TICKS_PER_SECOND);
+					break;
+				}
+			case source_engine::dmx::AttrType::Color:
+				outAttr->data = std::make_shared<std::array<uint8_t, 4>>(std::array<uint8_t, 4> {p[0], p[1], p[2], p[3]});
+				break;
+			case source_engine::dmx::AttrType::Vector2:
+				outAttr->data = std::make_shared<Vector2>(v[0], v[1]);
+				break;
+			case source_engine::dmx::AttrType::Vector3:
+				outAttr->data = std::make_shared<Vector3>(v[0], v[1], v[2]);
+				break;
+			case source_engine::dmx::AttrType::Vector4:
+				outAttr->data = std::make_shared<Vector4>(v[0], v[1], v[2], v[3]);
+				break;
+			case source_engine::dmx::AttrType::Angle:
+				outAttr->data = std::make_shared<EulerAngles>(v[0], v[1], v[2]);
+				break;
+			case source_engine::dmx::AttrType::Quaternion:
+				// Stored as x, y, z, w
+				outAttr->data = std::make_shared<Quat>(v[3], v[0], v[1], v[2]);
+				break;
+			case source_engine::dmx::AttrType::Matrix:
+				{
+					auto m = std::make_shared<Mat4>();
+					std::memcpy(m.get(), v.data(), sizeof(Mat4));
+					outAttr->data = m;
+					break;
+				}
+			default:
+				break;
+			}
+			break;
+		}
+	}
+	if(outAttr != nullptr)
+		outAttr->type = *attrType;
+	return true;
+}
+
+bool pragma::modules::dmx::LazyDocument::ReadArray(Reader &reader, uint8_t entryType, source_engine::dmx::Attribute *outAttr)
+{
+	auto attrType = get_attribute_type(entryType);
+	int32_t count;
+	if(!attrType.has_value() || !reader.Read(count) || count < 0)
+		return false;
+	if(outAttr == nullptr) {
+		auto size = get_value_size(entryType);
+		if(size > 0)
+			return reader.Consume(static_cast<uint64_t>(count) * size) != nullptr;
+		for(auto i = decltype(count) {0}; i < count; ++i) {
+			if(!ReadValue(reader, entryType, true, nullptr))
+				return false;
+		}
+		return true;
+	}
+	// The block has already been validated by Open at this point, so 'count' can be trusted
+	auto values = std::make_shared<std::vector<std::shared_ptr<source_engine::dmx::Attribute>>>();
+	values->reserve(count);
+	for(auto i = decltype(count) {0}; i < count; ++i) {
+		auto value = std::make_shared<source_engine::dmx::Attribute>();
+		if(!ReadValue(reader, entryType, true, value.get()))
+			return false;
+		values->push_back(value);
+	}
+	outAttr->type = get_array_type(*attrType);
+	outAttr->data = values;
+	return true;
+}
+
+void pragma::modules::dmx::materialize(const std::shared_ptr<source_engine::dmx::Element> &el)
+{
+	auto *deleter = std::get_deleter<ShellDeleter>(el);
+	if(deleter == nullptr || deleter->state->decoded.load(std::memory_order_acquire))
+		return;
+	// Elements of a document that has already been released stay empty
+	auto doc = deleter->state->document.lock();
+	if(doc == nullptr)
+		return;
+	doc->DecodeAttributes(deleter->state->index, *el, deleter->state->decoded);
+}
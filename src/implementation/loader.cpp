@@ -0,0 +1,113 @@
+// SPDX-FileCopyrightText: (c) 2020 Silverlan <opensource@pragma-engine.com>
+// SPDX-License-Identifier: MIT
+
+module pragma.modules.dmx;
+
+import :loader;
+import :mapped_file;
+import :data_info;
+import :stats;
+import :thread_pool;
+
+std::shared_ptr<ufile::IFile> pragma::modules::dmx::open_file(const std::string &path, std::string &outErr)
+{
+	auto f = pragma::fs::open_file(path, pragma::fs::FileMode::Read | pragma::fs::FileMode::Binary);
+	if(f == nullptr) {
+		outErr = "Unable to open file '" + path + "'!";
+		return nullptr;
+	}
+	return std::make_shared<pragma::fs::File>(f);
+}
+
+pragma::modules::dmx::LoadResult pragma::modules::dmx::load(const std::shared_ptr<ufile::IFile> &f)
+{
+	LoadResult result {};
+	LoadStats stats {};
+	auto startOffset = f->Tell();
+	auto t = std::chrono::steady_clock::now();
+	read_header(*f, stats);
+	stats.headerTimeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t).count();
+	t = std::chrono::steady_clock::now();
+	try {
+		result.data = source_engine::dmx::FileData::Load(f);
+	}
+	catch(const std::runtime_error &e) {
+		result.errorMessage = e.what();
+	}
+	catch(const std::logic_error &e) {
+		result.errorMessage = e.what();
+	}
+	if(result.data == nullptr)
+		return result;
+	stats.parseTimeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t).count();
+	stats.bytesRead = f->Tell() - startOffset;
+	DataRegistry::Get().Register(result.data)->SetLoadStats(stats);
+	return result;
+}
+
+pragma::modules::dmx::LoadResult pragma::modules::dmx::load(const std::string &path)
+{
+	LoadResult result {};
+	// Files on disk are parsed from a memory mapping, which avoids the per-read overhead of the file handle.
+	// util_dmx copies all payloads into the element graph, so the mapping can be released once Load has returned.
+	// Files that cannot be mapped (e.g. files inside of archives) are read through the file system instead.
+	std::string absPath;
+	std::unique_ptr<MappedFile> mf = nullptr;
+	if(pragma::fs::find_absolute_path(path, absPath)) {
+		std::string err;
+		mf = MappedFile::Open(absPath, err);
+	}
+	std::shared_ptr<ufile::IFile> f = nullptr;
+	if(mf != nullptr)
+		f = std::make_shared<ufile::MemoryFile>(const_cast<uint8_t *>(mf->GetData()), mf->GetSize());
+	else
+		f = open_file(path, result.errorMessage);
+	if(f == nullptr)
+		return result;
+	result = load(f);
+	if(result.data)
+		DataRegistry::Get().Register(result.data)->SetSourcePath(path);
+	return result;
+}
+
+std::shared_ptr<pragma::modules::dmx::LoadJob> pragma::modules::dmx::LoadJob::Start(std::function<LoadResult()> task)
+{
+	auto job = std::shared_ptr<LoadJob> {new LoadJob {}};
+	job->m_state = std::make_shared<State>();
+	ThreadPool::Get().Enqueue([state = job->m_state, task = std::move(task)]() {
+		LoadResult result {};
+		try {
+			result = task();
+		}
+		catch(const std::exception &e) {
+			result = {};
+			result.errorMessage = e.what();
+		}
+		{
+			std::scoped_lock lock {state->mutex};
+			state->result = std::move(result);
+		}
+		state->condition.notify_all();
+	});
+	return job;
+}
+
+bool pragma::modules::dmx::LoadJob::IsComplete() const
+{
+	std::scoped_lock lock {m_state->mutex};
+	return m_state->result.has_value();
+}
+
+const pragma::modules::dmx::LoadResult &pragma::modules::dmx::LoadJob::Wait()
+{
+	std::unique_lock lock {m_state->mutex};
+	m_state->condition.wait(lock, [this]() { return m_state->result.has_value(); });
+	// The result is never modified after it has been set
+	return *m_state->result;
+}
+
+const pragma::modules::dmx::LoadResult *pragma::modules::dmx::LoadJob::GetResult()
+{
+	std::scoped_lock lock {m_state->mutex};
+	return m_state->result.has_value() ? &*m_state->result : nullptr;
+}
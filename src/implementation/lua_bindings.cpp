@@ -6,226 +6,916 @@ module pragma.modules.dmx;
 import pragma.shared;
 import source_engine.dmx;
 
-static void print_attribute(std::stringstream &ss, source_engine::dmx::Attribute &attr, const std::string &t, std::unordered_map<source_engine::dmx::Element *, bool> &iteratedEls, std::unordered_map<source_engine::dmx::Attribute *, bool> &iteratedAttrs);
-static void print_element(std::stringstream &ss, source_engine::dmx::Element &e, const std::string &t, std::unordered_map<source_engine::dmx::Element *, bool> &iteratedEls, std::unordered_map<source_engine::dmx::Attribute *, bool> &iteratedAttrs)
+// Binary payloads are pushed as a BinaryView unless copyBinary is set, in which case they are copied into a DataStream
+static bool push_attribute_value(lua::State *l, source_engine::dmx::Attribute &attr, bool copyBinary = false)
 {
-	auto it = iteratedEls.find(&e);
-	if(it != iteratedEls.end())
-		return;
-	iteratedEls[&e] = true;
-
-	auto &attrs = e.attributes;
-	ss << t << e.name << " (" << e.type << ", " << attrs.size() << " attributes)";
-	for(auto &pair : attrs) {
-		ss << "\n\t" << t << pair.first;
-		print_attribute(ss, *pair.second, t + "\t\t", iteratedEls, iteratedAttrs);
-	}
-}
-
-static void print_attribute(std::stringstream &ss, source_engine::dmx::Attribute &attr, const std::string &t, std::unordered_map<source_engine::dmx::Element *, bool> &iteratedEls, std::unordered_map<source_engine::dmx::Attribute *, bool> &iteratedAttrs)
-{
-	auto it = iteratedAttrs.find(&attr);
-	if(it != iteratedAttrs.end())
-		return;
-	iteratedAttrs[&attr] = true;
-
-	ss << " (" << source_engine::dmx::type_to_string(attr.type) << "):\n";
-	if(attr.data == nullptr) {
-		ss << t << "NULL";
-		return;
-	}
+	pragma::modules::dmx::increment_counter(pragma::modules::dmx::Counter::GetValue);
+	if(attr.data == nullptr)
+		return false;
 	switch(attr.type) {
 	case source_engine::dmx::AttrType::Element:
 		{
 			auto &wpElement = *static_cast<std::weak_ptr<source_engine::dmx::Element> *>(attr.data.get());
 			if(wpElement.expired())
-				return;
-			print_element(ss, *wpElement.lock(), t + "\t", iteratedEls, iteratedAttrs);
+				return false;
+			Lua::Push<std::shared_ptr<source_engine::dmx::Element>>(l, wpElement.lock());
 			break;
 		}
 	case source_engine::dmx::AttrType::String:
-		ss << t << *static_cast<std::string *>(attr.data.get());
+		Lua::PushString(l, *static_cast<std::string *>(attr.data.get()));
 		break;
 	case source_engine::dmx::AttrType::Int:
-		ss << t << *static_cast<int32_t *>(attr.data.get());
+		Lua::PushInt(l, *static_cast<int32_t *>(attr.data.get()));
 		break;
 	case source_engine::dmx::AttrType::Float:
-		ss << t << *static_cast<float *>(attr.data.get());
+		Lua::PushNumber(l, *static_cast<float *>(attr.data.get()));
 		break;
 	case source_engine::dmx::AttrType::Bool:
-		ss << t << *static_cast<bool *>(attr.data.get());
+		Lua::PushBool(l, *static_cast<bool *>(attr.data.get()));
 		break;
 	case source_engine::dmx::AttrType::Vector2:
-		ss << t << *static_cast<Vector2 *>(attr.data.get());
+		Lua::Push<Vector2>(l, *static_cast<Vector2 *>(attr.data.get()));
 		break;
 	case source_engine::dmx::AttrType::Vector3:
-		ss << t << *static_cast<Vector3 *>(attr.data.get());
+		Lua::Push<Vector3>(l, *static_cast<Vector3 *>(attr.data.get()));
 		break;
 	case source_engine::dmx::AttrType::Angle:
-		ss << t << *static_cast<EulerAngles *>(attr.data.get());
+		Lua::Push<EulerAngles>(l, *static_cast<EulerAngles *>(attr.data.get()));
 		break;
 	case source_engine::dmx::AttrType::Vector4:
-		ss << t << *static_cast<Vector4 *>(attr.data.get());
+		Lua::Push<Vector4>(l, *static_cast<Vector4 *>(attr.data.get()));
 		break;
 	case source_engine::dmx::AttrType::Quaternion:
-		ss << t << *static_cast<Quat *>(attr.data.get());
+		Lua::Push<Quat>(l, *static_cast<Quat *>(attr.data.get()));
 		break;
 	case source_engine::dmx::AttrType::Matrix:
-		ss << t << *static_cast<Mat4 *>(attr.data.get());
+		Lua::Push<Mat4>(l, *static_cast<Mat4 *>(attr.data.get()));
 		break;
 	case source_engine::dmx::AttrType::Color:
 		{
 			auto &c = *static_cast<std::array<uint8_t, 4> *>(attr.data.get());
-			ss << t << +c.at(0) << " " << +c.at(1) << " " << +c.at(2) << " " << +c.at(3);
+			Lua::Push<Color>(l, Color(c.at(0), c.at(1), c.at(2), c.at(3)));
 			break;
 		}
 	case source_engine::dmx::AttrType::Time:
-		ss << t << *static_cast<float *>(attr.data.get());
+		Lua::PushNumber(l, *static_cast<float *>(attr.data.get()));
 		break;
 	case source_engine::dmx::AttrType::Binary:
 		{
-			auto &data = *static_cast<std::vector<uint8_t> *>(attr.data.get());
-			auto len = data.size();
-			ss << t << "Binary (" << len << " bytes)";
+			auto view = pragma::modules::dmx::BinaryView::Create(attr);
+			if(!view.has_value())
+				return false;
+			if(copyBinary)
+				Lua::Push<pragma::util::DataStream>(l, view->ToDataStream());
+			else
+				Lua::Push<pragma::modules::dmx::BinaryView>(l, *view);
 			break;
 		}
 	default:
 		{
 			if(attr.type >= source_engine::dmx::AttrType::ArrayFirst && attr.type <= source_engine::dmx::AttrType::ArrayLast) {
 				auto &vdata = *static_cast<std::vector<std::shared_ptr<source_engine::dmx::Attribute>> *>(attr.data.get());
-				ss << t << "Array [" << source_engine::dmx::type_to_string(attr.type) << "][" << vdata.size() << " elements]";
-				//ss<<t<<"Array of type "<<source_engine::dmx::::type_to_string(source_engine::dmx::::get_single_type(attr.type))<<" ["<<vdata.size()<<" elements]";
-				//for(auto &subAttr : vdata)
-				//	print_attribute(ss,*subAttr,t +"\t",iteratedEls,iteratedAttrs);
+				auto t = Lua::CreateTable(l);
+				auto idx = 1u;
+				for(auto &subAttr : vdata) {
+					Lua::PushInt(l, idx++);
+					Lua::Push<std::shared_ptr<source_engine::dmx::Attribute>>(l, subAttr);
+					Lua::SetTableValue(l, t);
+				}
 			}
 			break;
 		}
 	}
+	return true;
 }
 
-static bool push_attribute_value(lua::State *l, source_engine::dmx::Attribute &attr)
+// Converts an element and everything it references into nested Lua tables in a single call.
+// Every element is converted at most once, so elements that are referenced multiple times (including cycles) map to the same table.
+class TableConverter {
+  public:
+	struct Options {
+		uint32_t maxDepth = 64; // Elements deeper than this are pushed as Element handles
+		std::optional<std::unordered_set<source_engine::dmx::AttrType>> types {}; // If set, attributes of other types are skipped
+		bool arraysAsBuffer = false;                                             // Numeric arrays as packed DataStream instead of tables
+	};
+	// Lua stack slots used by one element level: its table, the attribute table, an attribute key and value, and an array table with an index and value
+	static constexpr int32_t STACK_SLOTS_PER_LEVEL = 8;
+	TableConverter(lua::State *l, const Options &options) : m_luaState {l}, m_options {options} {}
+	void PushElement(const std::shared_ptr<source_engine::dmx::Element> &el, uint32_t depth)
+	{
+		pragma::modules::dmx::materialize(el);
+		auto *l = m_luaState;
+		auto t = Lua::CreateTable(l);
+		m_tables.emplace(el.get(), luabind::object {luabind::from_stack(l, t)});
+
+		Lua::PushString(l, "name");
+		Lua::PushString(l, el->name);
+		Lua::SetTableValue(l, t);
+		Lua::PushString(l, "type");
+		Lua::PushString(l, el->type);
+		Lua::SetTableValue(l, t);
+		Lua::PushString(l, "guid");
+		Lua::PushString(l, el->GetGUIDAsString());
+		Lua::SetTableValue(l, t);
+
+		Lua::PushString(l, "attributes");
+		auto tAttrs = Lua::CreateTable(l);
+		for(auto &pair : el->attributes) {
+			auto &attr = pair.second;
+			if(attr == nullptr || (m_options.types.has_value() && !m_options.types->contains(attr->type)))
+				continue;
+			Lua::PushString(l, pair.first);
+			if(!PushAttribute(*attr, depth)) {
+				Lua::Pop(l, 1);
+				continue;
+			}
+			Lua::SetTableValue(l, tAttrs);
+		}
+		Lua::SetTableValue(l, t);
+	}
+  private:
+	void PushElementReference(const std::shared_ptr<source_engine::dmx::Element> &el, uint32_t depth)
+	{
+		auto it = m_tables.find(el.get());
+		if(it != m_tables.end()) {
+			it->second.push(m_luaState);
+			return;
+		}
+		// The slot for the handle itself has been reserved by the parent level
+		if(depth > m_options.maxDepth || !lua_checkstack(m_luaState, STACK_SLOTS_PER_LEVEL)) {
+			Lua::Push<std::shared_ptr<source_engine::dmx::Element>>(m_luaState, el);
+			return;
+		}
+		PushElement(el, depth);
+	}
+	bool PushAttribute(source_engine::dmx::Attribute &attr, uint32_t depth)
+	{
+		auto *l = m_luaState;
+		if(attr.data == nullptr)
+			return false;
+		if(attr.type == source_engine::dmx::AttrType::Element) {
+			auto el = static_cast<std::weak_ptr<source_engine::dmx::Element> *>(attr.data.get())->lock();
+			if(el == nullptr)
+				return false;
+			PushElementReference(el, depth + 1);
+			return true;
+		}
+		auto *values = pragma::modules::dmx::get_array_values(attr);
+		if(values == nullptr)
+			return push_attribute_value(l, attr);
+		if(m_options.arraysAsBuffer) {
+			auto layout = pragma::modules::dmx::get_array_layout(attr.type);
+			if(layout.has_value()) {
+				pragma::util::DataStream ds(values->size() * layout->GetEntrySize());
+				pragma::modules::dmx::pack_array(attr, ds);
+				ds->SetOffset(0);
+				Lua::Push<pragma::util::DataStream>(l, ds);
+				return true;
+			}
+		}
+		// Entries that can't be converted (e.g. expired element references) leave a hole, so the remaining entries keep their indices
+		auto t = Lua::CreateTable(l);
+		auto idx = 1u;
+		for(auto &val : *values) {
+			Lua::PushInt(l, idx++);
+			if(val == nullptr || !PushAttribute(*val, depth)) {
+				Lua::Pop(l, 1);
+				continue;
+			}
+			Lua::SetTableValue(l, t);
+		}
+		return true;
+	}
+
+	lua::State *m_luaState;
+	Options m_options;
+	std::unordered_map<const source_engine::dmx::Element *, luabind::object> m_tables;
+};
+
+static int32_t push_load_result(lua::State *l, const pragma::modules::dmx::LoadResult &result)
 {
-	if(attr.data == nullptr)
+	if(result.data == nullptr) {
+		Lua::PushBool(l, false);
+		if(result.errorMessage.empty())
+			return 1;
+		Lua::PushString(l, result.errorMessage);
+		return 2;
+	}
+	Lua::Push<std::shared_ptr<source_engine::dmx::FileData>>(l, result.data);
+	return 1;
+}
+
+static void push_query_match(lua::State *l, const pragma::modules::dmx::Query::Match &match)
+{
+	if(auto *el = std::get_if<std::shared_ptr<source_engine::dmx::Element>>(&match))
+		Lua::Push<std::shared_ptr<source_engine::dmx::Element>>(l, *el);
+	else
+		Lua::Push<std::shared_ptr<source_engine::dmx::Attribute>>(l, std::get<std::shared_ptr<source_engine::dmx::Attribute>>(match));
+}
+
+static void push_elements(lua::State *l, const std::vector<std::weak_ptr<source_engine::dmx::Element>> *elements)
+{
+	auto t = Lua::CreateTable(l);
+	if(elements == nullptr)
+		return;
+	auto idx = 1u;
+	for(auto &wpEl : *elements) {
+		auto el = wpEl.lock();
+		if(el == nullptr)
+			continue;
+		Lua::PushInt(l, idx++);
+		Lua::Push<std::shared_ptr<source_engine::dmx::Element>>(l, el);
+		Lua::SetTableValue(l, t);
+	}
+}
+
+// FileData that was not created by the loader (e.g. by another module) is registered on first use
+static std::shared_ptr<pragma::modules::dmx::DataInfo> get_data_info(const std::shared_ptr<source_engine::dmx::FileData> &data) { return pragma::modules::dmx::DataRegistry::Get().Register(data); }
+
+static bool push_frozen_value(lua::State *l, const pragma::modules::dmx::FrozenAttribute &attr)
+{
+	using pragma::modules::dmx::FrozenDocument;
+	auto &doc = *attr.document;
+	auto &rec = doc.GetAttribute(attr.index);
+	if(rec.payload == FrozenDocument::INVALID_INDEX)
 		return false;
-	switch(attr.type) {
+	auto type = attr.GetType();
+	if(attr.arrayIndex < 0 && pragma::modules::dmx::is_array_type(type)) {
+		auto t = Lua::CreateTable(l);
+		for(auto i = decltype(rec.count) {0u}; i < rec.count; ++i) {
+			Lua::PushInt(l, i + 1);
+			Lua::Push<pragma::modules::dmx::FrozenAttribute>(l, pragma::modules::dmx::FrozenAttribute {attr.document, attr.index, static_cast<int32_t>(i)});
+			Lua::SetTableValue(l, t);
+		}
+		return true;
+	}
+	auto payload = attr.GetPayload();
+	switch(type) {
 	case source_engine::dmx::AttrType::Element:
 		{
-			auto &wpElement = *static_cast<std::weak_ptr<source_engine::dmx::Element> *>(attr.data.get());
-			if(wpElement.expired())
+			auto elIdx = (attr.arrayIndex < 0) ? payload : *doc.GetElementRefs(rec.payload + attr.arrayIndex);
+			if(elIdx == FrozenDocument::INVALID_INDEX)
 				return false;
-			Lua::Push<std::shared_ptr<source_engine::dmx::Element>>(l, wpElement.lock());
+			Lua::Push<pragma::modules::dmx::FrozenElement>(l, pragma::modules::dmx::FrozenElement {attr.document, elIdx});
 			break;
 		}
 	case source_engine::dmx::AttrType::String:
-		Lua::PushString(l, *static_cast<std::string *>(attr.data.get()));
+		Lua::PushString(l, doc.GetString((attr.arrayIndex < 0) ? payload : *doc.GetStringRefs(rec.payload + attr.arrayIndex)));
 		break;
 	case source_engine::dmx::AttrType::Int:
-		Lua::PushInt(l, *static_cast<int32_t *>(attr.data.get()));
+		Lua::PushInt(l, *doc.GetInts(payload));
 		break;
 	case source_engine::dmx::AttrType::Float:
-		Lua::PushNumber(l, *static_cast<float *>(attr.data.get()));
+	case source_engine::dmx::AttrType::Time:
+		Lua::PushNumber(l, *doc.GetFloats(payload));
 		break;
 	case source_engine::dmx::AttrType::Bool:
-		Lua::PushBool(l, *static_cast<bool *>(attr.data.get()));
+		Lua::PushBool(l, *doc.GetBytes(payload) != 0);
 		break;
 	case source_engine::dmx::AttrType::Vector2:
-		Lua::Push<Vector2>(l, *static_cast<Vector2 *>(attr.data.get()));
-		break;
+		{
+			auto *v = doc.GetFloats(payload);
+			Lua::Push<Vector2>(l, Vector2 {v[0], v[1]});
+			break;
+		}
 	case source_engine::dmx::AttrType::Vector3:
-		Lua::Push<Vector3>(l, *static_cast<Vector3 *>(attr.data.get()));
-		break;
+		{
+			auto *v = doc.GetFloats(payload);
+			Lua::Push<Vector3>(l, Vector3 {v[0], v[1], v[2]});
+			break;
+		}
 	case source_engine::dmx::AttrType::Angle:
-		Lua::Push<EulerAngles>(l, *static_cast<EulerAngles *>(attr.data.get()));
-		break;
+		{
+			auto *v = doc.GetFloats(payload);
+			Lua::Push<EulerAngles>(l, EulerAngles {v[0], v[1], v[2]});
+			break;
+		}
 	case source_engine::dmx::AttrType::Vector4:
-		Lua::Push<Vector4>(l, *static_cast<Vector4 *>(attr.data.get()));
-		break;
+		{
+			auto *v = doc.GetFloats(payload);
+			Lua::Push<Vector4>(l, Vector4 {v[0], v[1], v[2], v[3]});
+			break;
+		}
 	case source_engine::dmx::AttrType::Quaternion:
-		Lua::Push<Quat>(l, *static_cast<Quat *>(attr.data.get()));
-		break;
+		{
+			auto *v = doc.GetFloats(payload);
+			Lua::Push<Quat>(l, Quat {v[0], v[1], v[2], v[3]});
+			break;
+		}
 	case source_engine::dmx::AttrType::Matrix:
-		Lua::Push<Mat4>(l, *static_cast<Mat4 *>(attr.data.get()));
-		break;
+		{
+			Mat4 m;
+			std::memcpy(&m, doc.GetFloats(payload), sizeof(m));
+			Lua::Push<Mat4>(l, m);
+			break;
+		}
 	case source_engine::dmx::AttrType::Color:
 		{
-			auto &c = *static_cast<std::array<uint8_t, 4> *>(attr.data.get());
-			Lua::Push<Color>(l, Color(c.at(0), c.at(1), c.at(2), c.at(3)));
+			auto *c = doc.GetBytes(payload);
+			Lua::Push<Color>(l, Color(c[0], c[1], c[2], c[3]));
 			break;
 		}
-	case source_engine::dmx::AttrType::Time:
-		Lua::PushNumber(l, *static_cast<float *>(attr.data.get()));
-		break;
 	case source_engine::dmx::AttrType::Binary:
 		{
-			auto &data = *static_cast<std::vector<uint8_t> *>(attr.data.get());
-			auto len = data.size();
-			pragma::util::DataStream ds(len);
-			ds->Write(data.data(), data.size());
-			Lua::Push<pragma::util::DataStream>(l, ds);
+			auto &range = doc.GetBinaryRange((attr.arrayIndex < 0) ? payload : rec.payload + attr.arrayIndex);
+			// Shares ownership of the document
+			std::shared_ptr<const std::vector<uint8_t>> data {attr.document, &doc.GetBinaryBuffer()};
+			Lua::Push<pragma::modules::dmx::BinaryView>(l, pragma::modules::dmx::BinaryView {data, range.offset, range.size});
 			break;
 		}
 	default:
-		{
-			if(attr.type >= source_engine::dmx::AttrType::ArrayFirst && attr.type <= source_engine::dmx::AttrType::ArrayLast) {
-				auto &vdata = *static_cast<std::vector<std::shared_ptr<source_engine::dmx::Attribute>> *>(attr.data.get());
-				auto t = Lua::CreateTable(l);
-				auto idx = 1u;
-				for(auto &subAttr : vdata) {
-					Lua::PushInt(l, idx++);
-					Lua::Push<std::shared_ptr<source_engine::dmx::Attribute>>(l, subAttr);
-					Lua::SetTableValue(l, t);
-				}
+		return false;
+	}
+	return true;
+}
+
+static void push_frozen_attribute(lua::State *l, const std::shared_ptr<const pragma::modules::dmx::FrozenDocument> &doc, pragma::modules::dmx::FrozenDocument::Index idx)
+{
+	if(idx == pragma::modules::dmx::FrozenDocument::INVALID_INDEX)
+		return;
+	Lua::Push<pragma::modules::dmx::FrozenAttribute>(l, pragma::modules::dmx::FrozenAttribute {doc, idx});
+}
+
+static void push_frozen_element(lua::State *l, const std::shared_ptr<const pragma::modules::dmx::FrozenDocument> &doc, pragma::modules::dmx::FrozenDocument::Index idx)
+{
+	if(idx == pragma::modules::dmx::FrozenDocument::INVALID_INDEX)
+		return;
+	Lua::Push<pragma::modules::dmx::FrozenElement>(l, pragma::modules::dmx::FrozenElement {doc, idx});
+}
+
+static void push_extracted_mesh(lua::State *l, const pragma::modules::dmx::ExtractedMesh &mesh)
+{
+	auto t = Lua::CreateTable(l);
+	auto setInt = [l](int32_t t, const char *key, int64_t value) {
+		Lua::PushString(l, key);
+		Lua::PushInt(l, value);
+		Lua::SetTableValue(l, t);
+	};
+	// The streams are shared with the extracted mesh, not copied
+	auto setDataStream = [l, t](const char *key, const pragma::util::DataStream &ds) {
+		Lua::PushString(l, key);
+		Lua::Push<pragma::util::DataStream>(l, ds);
+		Lua::SetTableValue(l, t);
+	};
+
+	Lua::PushString(l, "mesh");
+	Lua::Push<std::shared_ptr<source_engine::dmx::Element>>(l, mesh.mesh);
+	Lua::SetTableValue(l, t);
+
+	setInt(t, "vertexCount", mesh.vertexCount);
+	setInt(t, "vertexStride", mesh.vertexStride);
+	setDataStream("vertices", mesh.vertices);
+	setInt(t, "indexCount", mesh.indexCount);
+	setDataStream("indices", mesh.indices);
+	setInt(t, "jointCount", mesh.jointCount);
+	if(mesh.jointCount > 0)
+		setDataStream("boneWeights", mesh.boneWeights);
+
+	Lua::PushString(l, "streams");
+	auto tStreams = Lua::CreateTable(l);
+	for(auto i = decltype(mesh.streams.size()) {0u}; i < mesh.streams.size(); ++i) {
+		auto &stream = mesh.streams[i];
+		Lua::PushInt(l, i + 1);
+		auto tStream = Lua::CreateTable(l);
+		Lua::PushString(l, "name");
+		Lua::PushString(l, stream.name);
+		Lua::SetTableValue(l, tStream);
+		setInt(tStream, "type", pragma::math::to_integral(stream.type));
+		setInt(tStream, "offset", stream.offset);
+		setInt(tStream, "componentCount", stream.componentCount);
+		Lua::SetTableValue(l, tStreams);
+	}
+	Lua::SetTableValue(l, t);
+
+	Lua::PushString(l, "faceSets");
+	auto tFaceSets = Lua::CreateTable(l);
+	for(auto i = decltype(mesh.faceSets.size()) {0u}; i < mesh.faceSets.size(); ++i) {
+		auto &faceSet = mesh.faceSets[i];
+		Lua::PushInt(l, i + 1);
+		auto tFaceSet = Lua::CreateTable(l);
+		if(faceSet.material) {
+			Lua::PushString(l, "material");
+			Lua::Push<std::shared_ptr<source_engine::dmx::Element>>(l, faceSet.material);
+			Lua::SetTableValue(l, tFaceSet);
+		}
+		setInt(tFaceSet, "firstIndex", faceSet.firstIndex);
+		setInt(tFaceSet, "indexCount", faceSet.indexCount);
+		Lua::SetTableValue(l, tFaceSets);
+	}
+	Lua::SetTableValue(l, t);
+}
+
+// Reads an optional field from the options table at 'tIdx'
+template<typename T>
+static T get_option(lua::State *l, int32_t tIdx, const char *key, T defaultValue)
+{
+	if(!Lua::IsSet(l, tIdx))
+		return defaultValue;
+	Lua::CheckTable(l, tIdx);
+	Lua::PushString(l, key);
+	Lua::GetTableValue(l, tIdx);
+	auto value = defaultValue;
+	if constexpr(std::is_same_v<T, bool>) {
+		if(Lua::IsBool(l, -1))
+			value = Lua::CheckBool(l, -1);
+	}
+	else if constexpr(std::is_same_v<T, std::string>) {
+		if(Lua::IsString(l, -1))
+			value = Lua::CheckString(l, -1);
+	}
+	else {
+		if(Lua::IsNumber(l, -1))
+			value = static_cast<T>(Lua::CheckNumber(l, -1));
+	}
+	Lua::Pop(l, 1);
+	return value;
+}
+
+static std::shared_ptr<source_engine::dmx::Element> get_root_element(source_engine::dmx::FileData &data)
+{
+	auto &attr = data.GetRootAttribute();
+	if(attr == nullptr || attr->type != source_engine::dmx::AttrType::Element || attr->data == nullptr)
+		return nullptr;
+	return static_cast<std::weak_ptr<source_engine::dmx::Element> *>(attr->data.get())->lock();
+}
+
+// Limits used by __tostring, which may be invoked implicitly (e.g. by print) on arbitrarily large elements
+static pragma::modules::dmx::DumpOptions get_tostring_dump_options()
+{
+	pragma::modules::dmx::DumpOptions options {};
+	options.maxDepth = 1;
+	options.maxElements = 64;
+	options.maxBytes = 16 * 1'024;
+	return options;
+}
+
+static pragma::modules::dmx::DumpOptions read_dump_options(lua::State *l, int32_t tIdx)
+{
+	pragma::modules::dmx::DumpOptions options {};
+	auto format = get_option<std::string>(l, tIdx, "format", "text");
+	if(format == "json")
+		options.format = pragma::modules::dmx::DumpOptions::Format::Json;
+	else if(format != "text")
+		Lua::Error(l, "Invalid dump format '" + format + "', expected \"text\" or \"json\"");
+	options.maxDepth = get_option<uint32_t>(l, tIdx, "depth", options.maxDepth);
+	options.maxElements = get_option<uint64_t>(l, tIdx, "maxElements", options.maxElements);
+	options.maxBytes = get_option<uint64_t>(l, tIdx, "maxBytes", options.maxBytes);
+	options.maxArrayEntries = get_option<uint32_t>(l, tIdx, "arrayEntries", options.maxArrayEntries);
+	return options;
+}
+
+// Pushes the output and whether it was truncated
+template<typename T>
+static void push_dump(lua::State *l, T &target, const pragma::modules::dmx::DumpOptions &options)
+{
+	std::string out;
+	auto sink = [&out](std::string_view str) { out += str; };
+	auto result = pragma::modules::dmx::dump(target, options, sink);
+	Lua::PushString(l, out);
+	Lua::PushBool(l, result.truncated);
+}
+
+// Streams the output to the file and pushes whether it was truncated
+template<typename T>
+static void push_dump_to_file(lua::State *l, T &target, LFile &f, const pragma::modules::dmx::DumpOptions &options)
+{
+	auto hFile = f.GetHandle();
+	if(hFile == nullptr)
+		return;
+	auto sink = [&hFile](std::string_view str) { hFile->Write(str.data(), str.size()); };
+	auto result = pragma::modules::dmx::dump(target, options, sink);
+	Lua::PushBool(l, result.truncated);
+}
+
+static void push_diff(lua::State *l, const pragma::modules::dmx::Diff &diff)
+{
+	auto t = Lua::CreateTable(l);
+	auto setInt = [l](int32_t t, const char *key, int64_t value) {
+		Lua::PushString(l, key);
+		Lua::PushInt(l, value);
+		Lua::SetTableValue(l, t);
+	};
+	auto setBool = [l](int32_t t, const char *key, bool value) {
+		Lua::PushString(l, key);
+		Lua::PushBool(l, value);
+		Lua::SetTableValue(l, t);
+	};
+	auto setString = [l](int32_t t, const char *key, const std::string &value) {
+		Lua::PushString(l, key);
+		Lua::PushString(l, value);
+		Lua::SetTableValue(l, t);
+	};
+	auto setElements = [l, t](const char *key, const std::vector<std::shared_ptr<source_engine::dmx::Element>> &elements) {
+		Lua::PushString(l, key);
+		auto tElements = Lua::CreateTable(l);
+		for(auto i = decltype(elements.size()) {0u}; i < elements.size(); ++i) {
+			Lua::PushInt(l, i + 1);
+			Lua::Push<std::shared_ptr<source_engine::dmx::Element>>(l, elements[i]);
+			Lua::SetTableValue(l, tElements);
+		}
+		Lua::SetTableValue(l, t);
+	};
+	setElements("added", diff.added);
+	setElements("removed", diff.removed);
+
+	Lua::PushString(l, "changed");
+	auto tChanged = Lua::CreateTable(l);
+	for(auto i = decltype(diff.changed.size()) {0u}; i < diff.changed.size(); ++i) {
+		auto &change = diff.changed[i];
+		Lua::PushInt(l, i + 1);
+		auto tChange = Lua::CreateTable(l);
+		Lua::PushString(l, "element");
+		Lua::Push<std::shared_ptr<source_engine::dmx::Element>>(l, change.oldElement);
+		Lua::SetTableValue(l, tChange);
+		if(change.newElement) {
+			Lua::PushString(l, "newElement");
+			Lua::Push<std::shared_ptr<source_engine::dmx::Element>>(l, change.newElement);
+			Lua::SetTableValue(l, tChange);
+		}
+		setString(tChange, "guid", change.guid);
+		setBool(tChange, "nameChanged", change.nameChanged);
+		setBool(tChange, "typeChanged", change.typeChanged);
+
+		Lua::PushString(l, "attributes");
+		auto tAttrs = Lua::CreateTable(l);
+		for(auto j = decltype(change.attributes.size()) {0u}; j < change.attributes.size(); ++j) {
+			auto &attrChange = change.attributes[j];
+			Lua::PushInt(l, j + 1);
+			auto tAttr = Lua::CreateTable(l);
+			setString(tAttr, "name", attrChange.name);
+			switch(attrChange.kind) {
+			case pragma::modules::dmx::AttributeChange::Kind::Added:
+				setString(tAttr, "kind", "added");
+				break;
+			case pragma::modules::dmx::AttributeChange::Kind::Removed:
+				setString(tAttr, "kind", "removed");
+				break;
+			default:
+				setString(tAttr, "kind", "changed");
+				break;
+			}
+			setInt(tAttr, "oldType", pragma::math::to_integral(attrChange.oldType));
+			setInt(tAttr, "newType", pragma::math::to_integral(attrChange.newType));
+			setInt(tAttr, "oldCount", attrChange.oldCount);
+			setInt(tAttr, "newCount", attrChange.newCount);
+
+			Lua::PushString(l, "ranges");
+			auto tRanges = Lua::CreateTable(l);
+			for(auto k = decltype(attrChange.ranges.size()) {0u}; k < attrChange.ranges.size(); ++k) {
+				Lua::PushInt(l, k + 1);
+				auto tRange = Lua::CreateTable(l);
+				setInt(tRange, "start", attrChange.ranges[k].start + 1);
+				setInt(tRange, "count", attrChange.ranges[k].count);
+				Lua::SetTableValue(l, tRanges);
 			}
+			Lua::SetTableValue(l, tAttr);
+			Lua::SetTableValue(l, tAttrs);
+		}
+		Lua::SetTableValue(l, tChange);
+		Lua::SetTableValue(l, tChanged);
+	}
+	Lua::SetTableValue(l, t);
+}
+
+// If a cache budget has been set, the returned FileData may be shared with other callers, see FileCache
+static pragma::modules::dmx::LoadResult load_cached(const std::string &path)
+{
+	return pragma::modules::dmx::FileCache::Get().Load(path, static_cast<pragma::modules::dmx::LoadResult (*)(const std::string &)>(&pragma::modules::dmx::load));
+}
+
+// Completion callbacks of asynchronous loads. They are only ever invoked from dmx.poll_jobs, which the
+// script has to call regularly (e.g. once per tick). This guarantees that the FileData reaches Lua on the
+// thread that owns the Lua state.
+struct PendingLoadCallback {
+	luabind::object job; // Keeps the LoadJob alive while the callback is pending
+	pragma::modules::dmx::LoadJob *jobPtr = nullptr;
+	luabind::object callback;
+};
+static std::unordered_map<lua::State *, std::vector<PendingLoadCallback>> g_pendingLoadCallbacks;
+
+// Calls the callbacks of all completed jobs. A callback that raises an error does not prevent the remaining
+// callbacks from being called, its error message is added to 'outErrors' instead.
+static void dispatch_load_callbacks(lua::State *l, std::vector<std::string> &outErrors)
+{
+	auto it = g_pendingLoadCallbacks.find(l);
+	if(it == g_pendingLoadCallbacks.end())
+		return;
+	for(;;) {
+		// The list may be modified by the callbacks, so it has to be re-checked after every call
+		auto &pending = it->second;
+		auto itCb = std::find_if(pending.begin(), pending.end(), [](const PendingLoadCallback &cb) { return cb.jobPtr->IsComplete(); });
+		if(itCb == pending.end())
 			break;
+		auto cb = std::move(*itCb);
+		pending.erase(itCb);
+
+		auto &result = cb.jobPtr->Wait();
+		try {
+			if(result.IsSuccessful())
+				luabind::call_function<void>(cb.callback, result.data);
+			else
+				luabind::call_function<void>(cb.callback, false, result.errorMessage);
 		}
+		catch(const luabind::error &e) {
+			// luabind leaves the Lua error message on the stack
+			outErrors.push_back(Lua::IsString(l, -1) ? std::string {Lua::CheckString(l, -1)} : std::string {e.what()});
+			Lua::Pop(l, 1);
+		}
+		catch(const std::exception &e) {
+			outErrors.push_back(e.what());
+		}
+		it = g_pendingLoadCallbacks.find(l);
+		if(it == g_pendingLoadCallbacks.end())
+			break;
 	}
-	return true;
 }
 
+void Lua::dmx::unregister_lua_library(Lua::Interface &l) { g_pendingLoadCallbacks.erase(l.GetState()); }
+
 void Lua::dmx::register_lua_library(Lua::Interface &l)
 {
 	Lua::RegisterLibrary(l.GetState(), "dmx",
 	  {
 	    {"load", static_cast<int32_t (*)(lua::State *)>([](lua::State *l) {
+		     if(Lua::IsString(l, 1)) {
+			     std::string path = Lua::CheckString(l, 1);
+			     return push_load_result(l, load_cached(path));
+		     }
 		     auto &f = Lua::Check<LFile>(l, 1);
 		     auto hFile = f.GetHandle();
+		     return push_load_result(l, pragma::modules::dmx::load(hFile));
+	     })},
+	    // Opens a binary DMX file (encoding version 5) without parsing its element graph. Elements are decoded individually
+	    // the first time their attributes are accessed (see pragma::modules::dmx::LazyDocument). The result is not cached.
+	    {"load_lazy", static_cast<int32_t (*)(lua::State *)>([](lua::State *l) {
+		     std::string path = Lua::CheckString(l, 1);
+		     std::string err;
+		     auto doc = pragma::modules::dmx::LazyDocument::Open(path, err);
+		     if(doc == nullptr) {
+			     Lua::PushBool(l, false);
+			     Lua::PushString(l, err);
+			     return 2;
+		     }
+		     Lua::Push<std::shared_ptr<pragma::modules::dmx::LazyDocument>>(l, doc);
+		     return 1;
+	     })},
+	    {"load_async", static_cast<int32_t (*)(lua::State *)>([](lua::State *l) {
+		     std::shared_ptr<pragma::modules::dmx::LoadJob> job = nullptr;
+		     if(Lua::IsString(l, 1)) {
+			     std::string path = Lua::CheckString(l, 1);
+			     job = pragma::modules::dmx::LoadJob::Start([path]() { return load_cached(path); });
+		     }
+		     else {
+			     // The file handle must not be used by the caller until the job has completed
+			     auto &f = Lua::Check<LFile>(l, 1);
+			     auto hFile = f.GetHandle();
+			     job = pragma::modules::dmx::LoadJob::Start([hFile]() { return pragma::modules::dmx::load(hFile); });
+		     }
+		     Lua::Push<std::shared_ptr<pragma::modules::dmx::LoadJob>>(l, job);
+		     return 1;
+	     })},
+	    {"load_many", static_cast<int32_t (*)(lua::State *)>([](lua::State *l) {
+		     Lua::CheckTable(l, 1);
+		     std::vector<std::string> paths;
+		     auto n = Lua::GetObjectLength(l, 1);
+		     paths.reserve(n);
+		     for(auto i = decltype(n) {0u}; i < n; ++i) {
+			     Lua::PushInt(l, i + 1);
+			     Lua::GetTableValue(l, 1);
+			     paths.push_back(Lua::CheckString(l, -1));
+			     Lua::Pop(l, 1);
+		     }
+		     // The number of threads bounds how many files are being parsed (and buffered by the parser) at the same time
+		     auto threadCount = get_option<uint32_t>(l, 2, "threads", pragma::modules::dmx::get_default_thread_count());
+
+		     std::vector<pragma::modules::dmx::LoadResult> results(paths.size());
+		     // Failures are reported per file, nothing may be thrown through the Lua C function
+		     pragma::modules::dmx::parallel_for(paths.size(), threadCount, [&paths, &results](size_t i) {
+			     try {
+				     results[i] = load_cached(paths[i]);
+			     }
+			     catch(const std::exception &e) {
+				     results[i] = {};
+				     results[i].errorMessage = e.what();
+			     }
+		     });
+
+		     auto tResults = Lua::CreateTable(l);
+		     auto tErrors = Lua::CreateTable(l);
+		     for(auto i = decltype(results.size()) {0u}; i < results.size(); ++i) {
+			     auto &result = results[i];
+			     Lua::PushInt(l, i + 1);
+			     if(result.IsSuccessful())
+				     Lua::Push<std::shared_ptr<source_engine::dmx::FileData>>(l, result.data);
+			     else
+				     Lua::PushBool(l, false);
+			     Lua::SetTableValue(l, tResults);
 
-		     std::shared_ptr<source_engine::dmx::FileData> fd = nullptr;
-		     try {
-			     fd = source_engine::dmx::FileData::Load(hFile);
+			     if(result.IsSuccessful())
+				     continue;
+			     Lua::PushInt(l, i + 1);
+			     Lua::PushString(l, result.errorMessage.empty() ? "Unable to load DMX file" : result.errorMessage);
+			     Lua::SetTableValue(l, tErrors);
 		     }
-		     catch(const std::runtime_error &e) {
+		     return 2;
+	     })},
+	    // Calls the callbacks of completed jobs. Returns the number of callbacks that are still pending and the errors raised by callbacks.
+	    {"poll_jobs", static_cast<int32_t (*)(lua::State *)>([](lua::State *l) {
+		     std::vector<std::string> errors;
+		     dispatch_load_callbacks(l, errors);
+		     auto it = g_pendingLoadCallbacks.find(l);
+		     Lua::PushInt(l, (it != g_pendingLoadCallbacks.end()) ? it->second.size() : 0);
+		     auto tErrors = Lua::CreateTable(l);
+		     for(auto i = decltype(errors.size()) {0u}; i < errors.size(); ++i) {
+			     Lua::PushInt(l, i + 1);
+			     Lua::PushString(l, errors[i]);
+			     Lua::SetTableValue(l, tErrors);
+		     }
+		     return 2;
+	     })},
+	    {"compile_query", static_cast<int32_t (*)(lua::State *)>([](lua::State *l) {
+		     std::string source = Lua::CheckString(l, 1);
+		     std::string err;
+		     auto query = pragma::modules::dmx::Query::Compile(source, err);
+		     if(query == nullptr) {
 			     Lua::PushBool(l, false);
-			     Lua::PushString(l, e.what());
+			     Lua::PushString(l, err);
 			     return 2;
 		     }
-		     catch(const std::logic_error &e) {
+		     Lua::Push<std::shared_ptr<pragma::modules::dmx::Query>>(l, query);
+		     return 1;
+	     })},
+	    {"create_sampler", static_cast<int32_t (*)(lua::State *)>([](lua::State *l) {
+		     Lua::CheckTable(l, 1);
+		     std::vector<std::shared_ptr<source_engine::dmx::Element>> sources;
+		     auto n = Lua::GetObjectLength(l, 1);
+		     sources.reserve(n);
+		     for(auto i = decltype(n) {0u}; i < n; ++i) {
+			     Lua::PushInt(l, i + 1);
+			     Lua::GetTableValue(l, 1);
+			     sources.push_back(Lua::Check<std::shared_ptr<source_engine::dmx::Element>>(l, -1));
+			     Lua::Pop(l, 1);
+		     }
+		     std::string err;
+		     auto sampler = pragma::modules::dmx::Sampler::Create(sources, err);
+		     if(sampler == nullptr) {
 			     Lua::PushBool(l, false);
-			     Lua::PushString(l, e.what());
+			     Lua::PushString(l, err);
 			     return 2;
 		     }
-		     if(fd == nullptr) {
+		     Lua::Push<std::shared_ptr<pragma::modules::dmx::Sampler>>(l, sampler);
+		     return 1;
+	     })},
+	    {"extract_mesh", static_cast<int32_t (*)(lua::State *)>([](lua::State *l) {
+		     // Accepts a single element (DmeMesh, or e.g. a DmeModel that the meshes are collected from) or a table of elements
+		     std::vector<std::shared_ptr<source_engine::dmx::Element>> meshes;
+		     if(Lua::IsTable(l, 1)) {
+			     auto n = Lua::GetObjectLength(l, 1);
+			     for(auto i = decltype(n) {0u}; i < n; ++i) {
+				     Lua::PushInt(l, i + 1);
+				     Lua::GetTableValue(l, 1);
+				     auto found = pragma::modules::dmx::find_meshes(Lua::Check<std::shared_ptr<source_engine::dmx::Element>>(l, -1));
+				     meshes.insert(meshes.end(), found.begin(), found.end());
+				     Lua::Pop(l, 1);
+			     }
+		     }
+		     else
+			     meshes = pragma::modules::dmx::find_meshes(Lua::Check<std::shared_ptr<source_engine::dmx::Element>>(l, 1));
+
+		     pragma::modules::dmx::MeshLayout layout {};
+		     if(Lua::IsSet(l, 2)) {
+			     Lua::CheckTable(l, 2);
+			     Lua::PushString(l, "streams");
+			     Lua::GetTableValue(l, 2);
+			     if(Lua::IsTable(l, -1)) {
+				     auto tStreams = Lua::GetStackTop(l);
+				     auto n = Lua::GetObjectLength(l, tStreams);
+				     for(auto i = decltype(n) {0u}; i < n; ++i) {
+					     Lua::PushInt(l, i + 1);
+					     Lua::GetTableValue(l, tStreams);
+					     layout.streams.push_back(Lua::CheckString(l, -1));
+					     Lua::Pop(l, 1);
+				     }
+			     }
+			     Lua::Pop(l, 1);
+		     }
+		     layout.weld = get_option<bool>(l, 2, "weld", layout.weld);
+		     layout.boneWeights = get_option<bool>(l, 2, "boneWeights", layout.boneWeights);
+		     layout.threadCount = get_option<uint32_t>(l, 2, "threads", layout.threadCount);
+
+		     std::string err;
+		     auto results = pragma::modules::dmx::extract_meshes(meshes, layout, err);
+		     if(!results.has_value()) {
 			     Lua::PushBool(l, false);
-			     return 1;
+			     Lua::PushString(l, err);
+			     return 2;
 		     }
-		     Lua::Push<decltype(fd)>(l, fd);
+		     auto t = Lua::CreateTable(l);
+		     for(auto i = decltype(results->size()) {0u}; i < results->size(); ++i) {
+			     Lua::PushInt(l, i + 1);
+			     push_extracted_mesh(l, (*results)[i]);
+			     Lua::SetTableValue(l, t);
+		     }
+		     return 1;
+	     })},
+	    {"diff", static_cast<int32_t (*)(lua::State *)>([](lua::State *l) {
+		     auto oldData = Lua::Check<std::shared_ptr<source_engine::dmx::FileData>>(l, 1);
+		     auto newData = Lua::Check<std::shared_ptr<source_engine::dmx::FileData>>(l, 2);
+		     push_diff(l, pragma::modules::dmx::diff(*oldData, *newData));
 		     return 1;
 	     })},
+	    {"cache_stats", static_cast<int32_t (*)(lua::State *)>([](lua::State *l) {
+		     auto stats = pragma::modules::dmx::FileCache::Get().GetStats();
+		     auto t = Lua::CreateTable(l);
+		     auto setValue = [l, t](const char *key, uint64_t value) {
+			     Lua::PushString(l, key);
+			     Lua::PushInt(l, value);
+			     Lua::SetTableValue(l, t);
+		     };
+		     setValue("entryCount", stats.entryCount);
+		     setValue("memoryUsage", stats.memoryUsage);
+		     setValue("budget", stats.budget);
+		     setValue("hits", stats.hits);
+		     setValue("misses", stats.misses);
+		     setValue("evictions", stats.evictions);
+		     return 1;
+	     })},
+	    {"cache_clear", static_cast<int32_t (*)(lua::State *)>([](lua::State *l) {
+		     pragma::modules::dmx::FileCache::Get().Clear();
+		     return 0;
+	     })},
+	    {"set_cache_budget", static_cast<int32_t (*)(lua::State *)>([](lua::State *l) {
+		     auto budget = Lua::CheckInt(l, 1);
+		     pragma::modules::dmx::FileCache::Get().SetBudget(static_cast<size_t>(std::max<int64_t>(budget, 0)));
+		     return 0;
+	     })},
 	    {"type_to_string", static_cast<int32_t (*)(lua::State *)>([](lua::State *l) {
 		     auto type = Lua::CheckInt(l, 1);
 		     Lua::PushString(l, source_engine::dmx::type_to_string(static_cast<source_engine::dmx::AttrType>(type)));
 		     return 1;
 	     })},
+	    {"set_profiling_enabled", static_cast<int32_t (*)(lua::State *)>([](lua::State *l) {
+		     pragma::modules::dmx::set_profiling_enabled(Lua::CheckBool(l, 1));
+		     return 0;
+	     })},
+	    {"is_profiling_enabled", static_cast<int32_t (*)(lua::State *)>([](lua::State *l) {
+		     Lua::PushBool(l, pragma::modules::dmx::is_profiling_enabled());
+		     return 1;
+	     })},
+	    {"get_profiling_counters", static_cast<int32_t (*)(lua::State *)>([](lua::State *l) {
+		     auto t = Lua::CreateTable(l);
+		     for(auto i = 0u; i < pragma::math::to_integral(pragma::modules::dmx::Counter::Count); ++i) {
+			     auto counter = static_cast<pragma::modules::dmx::Counter>(i);
+			     Lua::PushString(l, std::string {pragma::modules::dmx::counter_to_string(counter)});
+			     Lua::PushInt(l, pragma::modules::dmx::get_counter(counter));
+			     Lua::SetTableValue(l, t);
+		     }
+		     return 1;
+	     })},
+	    {"reset_profiling_counters", static_cast<int32_t (*)(lua::State *)>([](lua::State *l) {
+		     pragma::modules::dmx::reset_counters();
+		     return 0;
+	     })},
 	  });
 
 	auto &modDMX = l.RegisterLibrary("dmx");
 	auto classDefData = luabind::class_<source_engine::dmx::FileData>("Data");
 	classDefData.def("__tostring", static_cast<void (*)(lua::State *, source_engine::dmx::FileData &)>([](lua::State *l, source_engine::dmx::FileData &data) {
-		std::stringstream ss;
-		data.DebugPrint(ss);
-		Lua::PushString(l, ss.str());
+		pragma::modules::dmx::increment_counter(pragma::modules::dmx::Counter::ToString);
+		auto root = get_root_element(data);
+		if(root == nullptr) {
+			Lua::PushString(l, "DMXData[" + std::to_string(data.GetElements().size()) + " elements]");
+			return;
+		}
+		push_dump(l, root, get_tostring_dump_options());
+		Lua::Pop(l, 1);
+	}));
+	classDefData.def("Dump", static_cast<void (*)(lua::State *, source_engine::dmx::FileData &)>([](lua::State *l, source_engine::dmx::FileData &data) {
+		auto root = get_root_element(data);
+		if(root == nullptr)
+			return;
+		push_dump(l, root, {});
+	}));
+	classDefData.def("Dump", static_cast<void (*)(lua::State *, source_engine::dmx::FileData &, luabind::object)>([](lua::State *l, source_engine::dmx::FileData &data, luabind::object oOptions) {
+		auto root = get_root_element(data);
+		if(root == nullptr)
+			return;
+		push_dump(l, root, read_dump_options(l, 2));
+	}));
+	classDefData.def("DumpToFile", static_cast<void (*)(lua::State *, source_engine::dmx::FileData &, LFile &)>([](lua::State *l, source_engine::dmx::FileData &data, LFile &f) {
+		auto root = get_root_element(data);
+		if(root == nullptr)
+			return;
+		push_dump_to_file(l, root, f, {});
+	}));
+	classDefData.def("DumpToFile", static_cast<void (*)(lua::State *, source_engine::dmx::FileData &, LFile &, luabind::object)>([](lua::State *l, source_engine::dmx::FileData &data, LFile &f, luabind::object oOptions) {
+		auto root = get_root_element(data);
+		if(root == nullptr)
+			return;
+		push_dump_to_file(l, root, f, read_dump_options(l, 3));
 	}));
 	classDefData.def("GetElements", static_cast<void (*)(lua::State *, source_engine::dmx::FileData &)>([](lua::State *l, source_engine::dmx::FileData &data) {
+		pragma::modules::dmx::increment_counter(pragma::modules::dmx::Counter::GetElements);
 		auto &elements = data.GetElements();
 		auto t = Lua::CreateTable(l);
 		auto elIdx = 1u;
@@ -235,63 +925,516 @@ void Lua::dmx::register_lua_library(Lua::Interface &l)
 			Lua::SetTableValue(l, t);
 		}
 	}));
+	classDefData.def("GetElementCount", static_cast<void (*)(lua::State *, source_engine::dmx::FileData &)>([](lua::State *l, source_engine::dmx::FileData &data) { Lua::PushInt(l, data.GetElements().size()); }));
+	classDefData.def("GetElement", static_cast<void (*)(lua::State *, source_engine::dmx::FileData &, uint32_t)>([](lua::State *l, source_engine::dmx::FileData &data, uint32_t idx) {
+		// Lua indices are 1-based, consistent with the table returned by GetElements
+		auto &elements = data.GetElements();
+		if(idx == 0 || idx > elements.size())
+			return;
+		Lua::Push<std::shared_ptr<source_engine::dmx::Element>>(l, elements[idx - 1]);
+	}));
+	classDefData.def("GetRootElement", static_cast<void (*)(lua::State *, source_engine::dmx::FileData &)>([](lua::State *l, source_engine::dmx::FileData &data) {
+		auto root = get_root_element(data);
+		if(root == nullptr)
+			return;
+		Lua::Push<std::shared_ptr<source_engine::dmx::Element>>(l, root);
+	}));
+	classDefData.def("FindByGUID", static_cast<void (*)(lua::State *, const std::shared_ptr<source_engine::dmx::FileData> &, const std::string &)>([](lua::State *l, const std::shared_ptr<source_engine::dmx::FileData> &data, const std::string &guid) {
+		auto info = get_data_info(data);
+		auto el = info->GetIndex().FindByGUID(guid);
+		if(el == nullptr)
+			return;
+		Lua::Push<std::shared_ptr<source_engine::dmx::Element>>(l, el);
+	}));
+	classDefData.def("FindByType", static_cast<void (*)(lua::State *, const std::shared_ptr<source_engine::dmx::FileData> &, const std::string &)>([](lua::State *l, const std::shared_ptr<source_engine::dmx::FileData> &data, const std::string &type) {
+		auto info = get_data_info(data);
+		push_elements(l, info->GetIndex().FindByType(type));
+	}));
+	classDefData.def("FindByName", static_cast<void (*)(lua::State *, const std::shared_ptr<source_engine::dmx::FileData> &, const std::string &)>([](lua::State *l, const std::shared_ptr<source_engine::dmx::FileData> &data, const std::string &name) {
+		auto info = get_data_info(data);
+		push_elements(l, info->GetIndex().FindByName(name));
+	}));
+	classDefData.def("GetStats", static_cast<void (*)(lua::State *, const std::shared_ptr<source_engine::dmx::FileData> &)>([](lua::State *l, const std::shared_ptr<source_engine::dmx::FileData> &data) {
+		// Load statistics are only available for data that was loaded through this module
+		auto info = get_data_info(data);
+		auto t = Lua::CreateTable(l);
+		auto setInt = [l](int32_t t, const char *key, int64_t value) {
+			Lua::PushString(l, key);
+			Lua::PushInt(l, value);
+			Lua::SetTableValue(l, t);
+		};
+		auto setNumber = [l](int32_t t, const char *key, double value) {
+			Lua::PushString(l, key);
+			Lua::PushNumber(l, value);
+			Lua::SetTableValue(l, t);
+		};
+
+		auto loadStats = info->GetLoadStats();
+		auto contentStats = info->GetContentStats();
+		if(loadStats.has_value()) {
+			Lua::PushString(l, "encoding");
+			Lua::PushString(l, loadStats->encoding);
+			Lua::SetTableValue(l, t);
+			setInt(t, "encodingVersion", loadStats->encodingVersion);
+			Lua::PushString(l, "format");
+			Lua::PushString(l, loadStats->format);
+			Lua::SetTableValue(l, t);
+			setInt(t, "formatVersion", loadStats->formatVersion);
+			setInt(t, "bytesRead", loadStats->bytesRead);
+		}
+
+		Lua::PushString(l, "timings");
+		auto tTimings = Lua::CreateTable(l);
+		if(loadStats.has_value()) {
+			setNumber(tTimings, "header", loadStats->headerTimeMs);
+			setNumber(tTimings, "parse", loadStats->parseTimeMs);
+		}
+		setNumber(tTimings, "analyze", contentStats.analyzeTimeMs);
+		Lua::SetTableValue(l, t);
+
+		setInt(t, "elementCount", contentStats.elementCount);
+		setInt(t, "attributeCount", contentStats.attributeCount);
+		setInt(t, "arrayEntryCount", contentStats.arrayEntryCount);
+		setInt(t, "arrayPayloadBytes", contentStats.arrayPayloadBytes);
+		setInt(t, "estimatedMemory", contentStats.estimatedMemory);
+
+		Lua::PushString(l, "attributesByType");
+		auto tTypes = Lua::CreateTable(l);
+		for(auto &[type, count] : contentStats.attributesByType)
+			setInt(tTypes, std::string {source_engine::dmx::type_to_string(type)}.c_str(), count);
+		Lua::SetTableValue(l, t);
+	}));
+	// Replaces the contents of the data, which affects everyone holding it (see pragma::modules::dmx::reload)
+	classDefData.def("Reload", static_cast<void (*)(lua::State *, source_engine::dmx::FileData &)>([](lua::State *l, source_engine::dmx::FileData &data) {
+		std::string err;
+		auto diff = pragma::modules::dmx::reload(data, err);
+		if(!diff.has_value()) {
+			Lua::PushBool(l, false);
+			Lua::PushString(l, err);
+			return;
+		}
+		push_diff(l, *diff);
+	}));
+	classDefData.def("Freeze", static_cast<void (*)(lua::State *, source_engine::dmx::FileData &)>([](lua::State *l, source_engine::dmx::FileData &data) {
+		Lua::Push<std::shared_ptr<pragma::modules::dmx::FrozenDocument>>(l, pragma::modules::dmx::FrozenDocument::Create(data));
+	}));
 	classDefData.def("GetRootAttribute", static_cast<void (*)(lua::State *, source_engine::dmx::FileData &)>([](lua::State *l, source_engine::dmx::FileData &data) {
 		auto &attr = data.GetRootAttribute();
 		Lua::Push<std::shared_ptr<source_engine::dmx::Attribute>>(l, attr);
 	}));
 	modDMX[classDefData];
 
+	// Elements are only decoded when their attributes are accessed, see dmx.load_lazy
+	using pragma::modules::dmx::LazyDocument;
+	auto classDefLazyData = luabind::class_<LazyDocument>("LazyData");
+	classDefLazyData.def("__tostring", static_cast<void (*)(lua::State *, LazyDocument &)>([](lua::State *l, LazyDocument &doc) {
+		Lua::PushString(l, "DMXLazyData[" + std::to_string(doc.GetElementCount()) + " elements][" + std::to_string(doc.GetDecodedElementCount()) + " decoded][" + pragma::util::get_pretty_bytes(doc.GetFileSize()) + "]");
+	}));
+	classDefLazyData.def("GetElementCount", static_cast<void (*)(lua::State *, LazyDocument &)>([](lua::State *l, LazyDocument &doc) { Lua::PushInt(l, doc.GetElementCount()); }));
+	classDefLazyData.def("GetDecodedElementCount", static_cast<void (*)(lua::State *, LazyDocument &)>([](lua::State *l, LazyDocument &doc) { Lua::PushInt(l, doc.GetDecodedElementCount()); }));
+	classDefLazyData.def("GetElement", static_cast<void (*)(lua::State *, LazyDocument &, uint32_t)>([](lua::State *l, LazyDocument &doc, uint32_t idx) {
+		// Lua indices are 1-based, consistent with Data:GetElement
+		if(idx == 0 || idx > doc.GetElementCount())
+			return;
+		Lua::Push<std::shared_ptr<source_engine::dmx::Element>>(l, doc.GetElement(idx - 1));
+	}));
+	classDefLazyData.def("GetRootElement", static_cast<void (*)(lua::State *, LazyDocument &)>([](lua::State *l, LazyDocument &doc) {
+		auto root = doc.GetElement(0);
+		if(root == nullptr)
+			return;
+		Lua::Push<std::shared_ptr<source_engine::dmx::Element>>(l, root);
+	}));
+	classDefLazyData.def("GetRootAttribute", static_cast<void (*)(lua::State *, LazyDocument &)>([](lua::State *l, LazyDocument &doc) {
+		auto &attr = doc.GetRootAttribute();
+		if(attr == nullptr)
+			return;
+		Lua::Push<std::shared_ptr<source_engine::dmx::Attribute>>(l, attr);
+	}));
+	modDMX[classDefLazyData];
+
+	auto classDefLoadJob = luabind::class_<pragma::modules::dmx::LoadJob>("LoadJob");
+	classDefLoadJob.def("IsComplete", static_cast<void (*)(lua::State *, pragma::modules::dmx::LoadJob &)>([](lua::State *l, pragma::modules::dmx::LoadJob &job) { Lua::PushBool(l, job.IsComplete()); }));
+	classDefLoadJob.def("Wait", static_cast<void (*)(lua::State *, pragma::modules::dmx::LoadJob &)>([](lua::State *l, pragma::modules::dmx::LoadJob &job) { push_load_result(l, job.Wait()); }));
+	classDefLoadJob.def("GetResult", static_cast<void (*)(lua::State *, pragma::modules::dmx::LoadJob &)>([](lua::State *l, pragma::modules::dmx::LoadJob &job) {
+		auto *result = job.GetResult();
+		if(result == nullptr)
+			return;
+		push_load_result(l, *result);
+	}));
+	// The callback is not called by the engine, it is called by the next dmx.poll_jobs after the job has completed
+	classDefLoadJob.def("SetCallback", static_cast<void (*)(lua::State *, pragma::modules::dmx::LoadJob &, luabind::object)>([](lua::State *l, pragma::modules::dmx::LoadJob &job, luabind::object callback) {
+		Lua::CheckFunction(l, 2);
+		auto &pending = g_pendingLoadCallbacks[l];
+		auto it = std::find_if(pending.begin(), pending.end(), [&job](const PendingLoadCallback &cb) { return cb.jobPtr == &job; });
+		if(it != pending.end()) {
+			it->callback = callback;
+			return;
+		}
+		pending.push_back({luabind::object {luabind::from_stack(l, 1)}, &job, callback});
+	}));
+	modDMX[classDefLoadJob];
+
 	auto classDefElement = luabind::class_<source_engine::dmx::Element>("Element");
-	classDefElement.def("__tostring", static_cast<void (*)(lua::State *, source_engine::dmx::Element &)>([](lua::State *l, source_engine::dmx::Element &el) {
-		std::stringstream ss;
-		el.DebugPrint(ss);
-		Lua::PushString(l, ss.str());
+	classDefElement.def("__tostring", static_cast<void (*)(lua::State *, const std::shared_ptr<source_engine::dmx::Element> &)>([](lua::State *l, const std::shared_ptr<source_engine::dmx::Element> &el) {
+		pragma::modules::dmx::increment_counter(pragma::modules::dmx::Counter::ToString);
+		push_dump(l, el, get_tostring_dump_options());
+		Lua::Pop(l, 1);
+	}));
+	classDefElement.def("Dump", static_cast<void (*)(lua::State *, const std::shared_ptr<source_engine::dmx::Element> &)>([](lua::State *l, const std::shared_ptr<source_engine::dmx::Element> &el) { push_dump(l, el, {}); }));
+	classDefElement.def("Dump", static_cast<void (*)(lua::State *, const std::shared_ptr<source_engine::dmx::Element> &, luabind::object)>([](lua::State *l, const std::shared_ptr<source_engine::dmx::Element> &el, luabind::object oOptions) { push_dump(l, el, read_dump_options(l, 2)); }));
+	classDefElement.def("DumpToFile", static_cast<void (*)(lua::State *, const std::shared_ptr<source_engine::dmx::Element> &, LFile &)>([](lua::State *l, const std::shared_ptr<source_engine::dmx::Element> &el, LFile &f) { push_dump_to_file(l, el, f, {}); }));
+	classDefElement.def("DumpToFile", static_cast<void (*)(lua::State *, const std::shared_ptr<source_engine::dmx::Element> &, LFile &, luabind::object)>([](lua::State *l, const std::shared_ptr<source_engine::dmx::Element> &el, LFile &f, luabind::object oOptions) {
+		push_dump_to_file(l, el, f, read_dump_options(l, 3));
 	}));
 	classDefElement.def("__eq", static_cast<void (*)(lua::State *, source_engine::dmx::Element &, source_engine::dmx::Element &)>([](lua::State *l, source_engine::dmx::Element &el, source_engine::dmx::Element &elOther) { Lua::PushBool(l, &el == &elOther); }));
 	classDefElement.def("GetGUID", static_cast<void (*)(lua::State *, source_engine::dmx::Element &)>([](lua::State *l, source_engine::dmx::Element &el) { Lua::PushString(l, el.GetGUIDAsString()); }));
-	classDefElement.def("Get", static_cast<void (*)(lua::State *, source_engine::dmx::Element &, const std::string &)>([](lua::State *l, source_engine::dmx::Element &el, const std::string &name) {
-		auto child = el.Get(name);
+	classDefElement.def("Get", static_cast<void (*)(lua::State *, const std::shared_ptr<source_engine::dmx::Element> &, const std::string &)>([](lua::State *l, const std::shared_ptr<source_engine::dmx::Element> &el, const std::string &name) {
+		pragma::modules::dmx::materialize(el);
+		pragma::modules::dmx::increment_counter(pragma::modules::dmx::Counter::Get);
+		auto child = el->Get(name);
 		if(child == nullptr)
 			return;
 		Lua::Push(l, child);
 	}));
-	classDefElement.def("GetAttr", static_cast<void (*)(lua::State *, source_engine::dmx::Element &, const std::string &)>([](lua::State *l, source_engine::dmx::Element &el, const std::string &name) {
-		auto attr = el.GetAttr(name);
+	classDefElement.def("GetAttr", static_cast<void (*)(lua::State *, const std::shared_ptr<source_engine::dmx::Element> &, const std::string &)>([](lua::State *l, const std::shared_ptr<source_engine::dmx::Element> &el, const std::string &name) {
+		pragma::modules::dmx::materialize(el);
+		pragma::modules::dmx::increment_counter(pragma::modules::dmx::Counter::GetAttr);
+		auto attr = el->GetAttr(name);
 		if(attr == nullptr)
 			return;
 		Lua::Push(l, attr);
 	}));
-	classDefElement.def("GetAttrV", static_cast<void (*)(lua::State *, source_engine::dmx::Element &, const std::string &)>([](lua::State *l, source_engine::dmx::Element &el, const std::string &name) {
-		auto attr = el.GetAttr(name);
+	classDefElement.def("GetAttrV", static_cast<void (*)(lua::State *, const std::shared_ptr<source_engine::dmx::Element> &, const std::string &)>([](lua::State *l, const std::shared_ptr<source_engine::dmx::Element> &el, const std::string &name) {
+		pragma::modules::dmx::materialize(el);
+		auto attr = el->GetAttr(name);
 		if(attr == nullptr)
 			return;
 		push_attribute_value(l, *attr);
 	}));
 	classDefElement.def("GetName", static_cast<void (*)(lua::State *, source_engine::dmx::Element &)>([](lua::State *l, source_engine::dmx::Element &el) { Lua::PushString(l, el.name); }));
 	classDefElement.def("GetType", static_cast<void (*)(lua::State *, source_engine::dmx::Element &)>([](lua::State *l, source_engine::dmx::Element &el) { Lua::PushString(l, el.type); }));
-	classDefElement.def("GetAttributes", static_cast<void (*)(lua::State *, source_engine::dmx::Element &)>([](lua::State *l, source_engine::dmx::Element &el) {
+	classDefElement.def("GetAttributes", static_cast<void (*)(lua::State *, const std::shared_ptr<source_engine::dmx::Element> &)>([](lua::State *l, const std::shared_ptr<source_engine::dmx::Element> &el) {
+		pragma::modules::dmx::materialize(el);
+		pragma::modules::dmx::increment_counter(pragma::modules::dmx::Counter::GetAttributes);
 		auto t = Lua::CreateTable(l);
 		auto attrId = 1u;
-		for(auto &pair : el.attributes) {
+		for(auto &pair : el->attributes) {
 			auto &attr = pair.second;
 			Lua::PushString(l, pair.first);
 			Lua::Push<std::shared_ptr<source_engine::dmx::Attribute>>(l, attr);
 			Lua::SetTableValue(l, t);
 		}
 	}));
-	classDefElement.def("GetAttribute", static_cast<void (*)(lua::State *, source_engine::dmx::Element &, const std::string &)>([](lua::State *l, source_engine::dmx::Element &el, const std::string &id) {
-		auto it = el.attributes.find(id);
-		if(it == el.attributes.end())
+	classDefElement.def("ToTable", static_cast<void (*)(lua::State *, const std::shared_ptr<source_engine::dmx::Element> &)>([](lua::State *l, const std::shared_ptr<source_engine::dmx::Element> &el) {
+		if(!lua_checkstack(l, TableConverter::STACK_SLOTS_PER_LEVEL))
+			Lua::Error(l, "Lua stack overflow");
+		TableConverter {l, {}}.PushElement(el, 0);
+	}));
+	classDefElement.def("ToTable", static_cast<void (*)(lua::State *, const std::shared_ptr<source_engine::dmx::Element> &, luabind::object)>([](lua::State *l, const std::shared_ptr<source_engine::dmx::Element> &el, luabind::object oOptions) {
+		TableConverter::Options options {};
+		options.maxDepth = get_option<uint32_t>(l, 2, "depth", options.maxDepth);
+		auto arraysAs = get_option<std::string>(l, 2, "arraysAs", "table");
+		if(arraysAs != "table" && arraysAs != "buffer")
+			Lua::Error(l, "Invalid value '" + arraysAs + "' for 'arraysAs', expected \"table\" or \"buffer\"");
+		options.arraysAsBuffer = (arraysAs == "buffer");
+		if(Lua::IsSet(l, 2)) {
+			Lua::CheckTable(l, 2);
+			Lua::PushString(l, "types");
+			Lua::GetTableValue(l, 2);
+			if(Lua::IsTable(l, -1)) {
+				// List of dmx.Attribute.TYPE_* values
+				auto tTypes = Lua::GetStackTop(l);
+				auto n = Lua::GetObjectLength(l, tTypes);
+				options.types = std::unordered_set<source_engine::dmx::AttrType> {};
+				for(auto i = decltype(n) {0u}; i < n; ++i) {
+					Lua::PushInt(l, i + 1);
+					Lua::GetTableValue(l, tTypes);
+					options.types->insert(static_cast<source_engine::dmx::AttrType>(Lua::CheckInt(l, -1)));
+					Lua::Pop(l, 1);
+				}
+			}
+			Lua::Pop(l, 1);
+		}
+		if(!lua_checkstack(l, TableConverter::STACK_SLOTS_PER_LEVEL))
+			Lua::Error(l, "Lua stack overflow");
+		TableConverter {l, options}.PushElement(el, 0);
+	}));
+	classDefElement.def("GetAttributeCount", static_cast<void (*)(lua::State *, const std::shared_ptr<source_engine::dmx::Element> &)>([](lua::State *l, const std::shared_ptr<source_engine::dmx::Element> &el) {
+		pragma::modules::dmx::materialize(el);
+		Lua::PushInt(l, el->attributes.size());
+	}));
+	classDefElement.def("GetAttributeNames", static_cast<void (*)(lua::State *, const std::shared_ptr<source_engine::dmx::Element> &)>([](lua::State *l, const std::shared_ptr<source_engine::dmx::Element> &el) {
+		pragma::modules::dmx::materialize(el);
+		auto t = Lua::CreateTable(l);
+		auto idx = 1u;
+		for(auto &pair : el->attributes) {
+			Lua::PushInt(l, idx++);
+			Lua::PushString(l, pair.first);
+			Lua::SetTableValue(l, t);
+		}
+	}));
+	classDefElement.def("HasAttribute", static_cast<void (*)(lua::State *, const std::shared_ptr<source_engine::dmx::Element> &, const std::string &)>([](lua::State *l, const std::shared_ptr<source_engine::dmx::Element> &el, const std::string &id) {
+		pragma::modules::dmx::materialize(el);
+		Lua::PushBool(l, el->attributes.find(id) != el->attributes.end());
+	}));
+	classDefElement.def("GetAttribute", static_cast<void (*)(lua::State *, const std::shared_ptr<source_engine::dmx::Element> &, const std::string &)>([](lua::State *l, const std::shared_ptr<source_engine::dmx::Element> &el, const std::string &id) {
+		pragma::modules::dmx::materialize(el);
+		pragma::modules::dmx::increment_counter(pragma::modules::dmx::Counter::GetAttr);
+		auto it = el->attributes.find(id);
+		if(it == el->attributes.end())
 			return;
 		Lua::Push<std::shared_ptr<source_engine::dmx::Attribute>>(l, it->second);
 	}));
-	classDefElement.def("GetAttributeValue", static_cast<void (*)(lua::State *, source_engine::dmx::Element &, const std::string &)>([](lua::State *l, source_engine::dmx::Element &el, const std::string &id) {
-		auto it = el.attributes.find(id);
-		if(it == el.attributes.end() || push_attribute_value(l, *it->second) == false)
+	classDefElement.def("GetAttributeValue", static_cast<void (*)(lua::State *, const std::shared_ptr<source_engine::dmx::Element> &, const std::string &)>([](lua::State *l, const std::shared_ptr<source_engine::dmx::Element> &el, const std::string &id) {
+		pragma::modules::dmx::materialize(el);
+		auto it = el->attributes.find(id);
+		if(it == el->attributes.end() || push_attribute_value(l, *it->second) == false)
 			return;
 	}));
 	modDMX[classDefElement];
 
+	auto classDefQuery = luabind::class_<pragma::modules::dmx::Query>("Query");
+	classDefQuery.def("__tostring", static_cast<void (*)(lua::State *, pragma::modules::dmx::Query &)>([](lua::State *l, pragma::modules::dmx::Query &query) { Lua::PushString(l, "DMXQuery[" + query.GetSource() + "]"); }));
+	classDefQuery.def("GetSource", static_cast<void (*)(lua::State *, pragma::modules::dmx::Query &)>([](lua::State *l, pragma::modules::dmx::Query &query) { Lua::PushString(l, query.GetSource()); }));
+	classDefQuery.def("Run", static_cast<void (*)(lua::State *, pragma::modules::dmx::Query &, const std::shared_ptr<source_engine::dmx::Element> &)>([](lua::State *l, pragma::modules::dmx::Query &query, const std::shared_ptr<source_engine::dmx::Element> &el) {
+		auto matches = query.Run(el);
+		auto t = Lua::CreateTable(l);
+		auto idx = 1u;
+		for(auto &match : matches) {
+			Lua::PushInt(l, idx++);
+			push_query_match(l, match);
+			Lua::SetTableValue(l, t);
+		}
+	}));
+	classDefQuery.def("RunFirst", static_cast<void (*)(lua::State *, pragma::modules::dmx::Query &, const std::shared_ptr<source_engine::dmx::Element> &)>([](lua::State *l, pragma::modules::dmx::Query &query, const std::shared_ptr<source_engine::dmx::Element> &el) {
+		auto matches = query.Run(el, 1);
+		if(matches.empty())
+			return;
+		push_query_match(l, matches.front());
+	}));
+	modDMX[classDefQuery];
+
+	auto classDefSampler = luabind::class_<pragma::modules::dmx::Sampler>("Sampler");
+	classDefSampler.def("__tostring", static_cast<void (*)(lua::State *, pragma::modules::dmx::Sampler &)>([](lua::State *l, pragma::modules::dmx::Sampler &sampler) {
+		Lua::PushString(l, "DMXSampler[" + std::to_string(sampler.GetChannelCount()) + " channels][" + std::to_string(sampler.GetOutputSize()) + " values]");
+	}));
+	classDefSampler.def("GetChannelCount", static_cast<void (*)(lua::State *, pragma::modules::dmx::Sampler &)>([](lua::State *l, pragma::modules::dmx::Sampler &sampler) { Lua::PushInt(l, sampler.GetChannelCount()); }));
+	classDefSampler.def("GetOutputSize", static_cast<void (*)(lua::State *, pragma::modules::dmx::Sampler &)>([](lua::State *l, pragma::modules::dmx::Sampler &sampler) { Lua::PushInt(l, sampler.GetOutputSize()); }));
+	classDefSampler.def("GetChannelOffset", static_cast<void (*)(lua::State *, pragma::modules::dmx::Sampler &, uint32_t)>([](lua::State *l, pragma::modules::dmx::Sampler &sampler, uint32_t idx) {
+		if(idx == 0 || idx > sampler.GetChannelCount())
+			return;
+		Lua::PushInt(l, sampler.GetChannel(idx - 1).outputOffset);
+	}));
+	classDefSampler.def("GetChannelType", static_cast<void (*)(lua::State *, pragma::modules::dmx::Sampler &, uint32_t)>([](lua::State *l, pragma::modules::dmx::Sampler &sampler, uint32_t idx) {
+		if(idx == 0 || idx > sampler.GetChannelCount())
+			return;
+		Lua::PushInt(l, pragma::math::to_integral(sampler.GetChannel(idx - 1).valueType));
+	}));
+	classDefSampler.def("GetTimeRange", static_cast<void (*)(lua::State *, pragma::modules::dmx::Sampler &)>([](lua::State *l, pragma::modules::dmx::Sampler &sampler) {
+		auto [start, end] = sampler.GetTimeRange();
+		Lua::PushNumber(l, start);
+		Lua::PushNumber(l, end);
+	}));
+	classDefSampler.def("Reset", static_cast<void (*)(lua::State *, pragma::modules::dmx::Sampler &)>([](lua::State *l, pragma::modules::dmx::Sampler &sampler) { sampler.Reset(); }));
+	// Writes the sampled values as floats at the current offset of the stream
+	classDefSampler.def("Sample", static_cast<void (*)(lua::State *, pragma::modules::dmx::Sampler &, float, pragma::util::DataStream &)>([](lua::State *l, pragma::modules::dmx::Sampler &sampler, float t, pragma::util::DataStream &ds) {
+		static thread_local std::vector<float> values;
+		values.resize(sampler.GetOutputSize());
+		sampler.Sample(t, values.data());
+		ds->Write(reinterpret_cast<uint8_t *>(values.data()), values.size() * sizeof(float));
+	}));
+	classDefSampler.def("Sample", static_cast<void (*)(lua::State *, pragma::modules::dmx::Sampler &, float)>([](lua::State *l, pragma::modules::dmx::Sampler &sampler, float t) {
+		std::vector<float> values(sampler.GetOutputSize());
+		sampler.Sample(t, values.data());
+		pragma::util::DataStream ds(values.size() * sizeof(float));
+		ds->Write(reinterpret_cast<uint8_t *>(values.data()), values.size() * sizeof(float));
+		ds->SetOffset(0);
+		Lua::Push<pragma::util::DataStream>(l, ds);
+	}));
+	modDMX[classDefSampler];
+
+	auto classDefBinaryView = luabind::class_<pragma::modules::dmx::BinaryView>("BinaryView");
+	classDefBinaryView.def("__tostring", static_cast<void (*)(lua::State *, pragma::modules::dmx::BinaryView &)>([](lua::State *l, pragma::modules::dmx::BinaryView &view) { Lua::PushString(l, "DMXBinaryView[" + pragma::util::get_pretty_bytes(view.GetSize()) + "]"); }));
+	classDefBinaryView.def("GetSize", static_cast<void (*)(lua::State *, pragma::modules::dmx::BinaryView &)>([](lua::State *l, pragma::modules::dmx::BinaryView &view) { Lua::PushInt(l, view.GetSize()); }));
+	classDefBinaryView.def("Slice", static_cast<void (*)(lua::State *, pragma::modules::dmx::BinaryView &, uint32_t, uint32_t)>([](lua::State *l, pragma::modules::dmx::BinaryView &view, uint32_t offset, uint32_t size) {
+		auto slice = view.Slice(offset, size);
+		if(!slice.has_value())
+			return;
+		Lua::Push<pragma::modules::dmx::BinaryView>(l, *slice);
+	}));
+	classDefBinaryView.def("ToDataStream", static_cast<void (*)(lua::State *, pragma::modules::dmx::BinaryView &)>([](lua::State *l, pragma::modules::dmx::BinaryView &view) { Lua::Push<pragma::util::DataStream>(l, view.ToDataStream()); }));
+	classDefBinaryView.def("ReadString", static_cast<void (*)(lua::State *, pragma::modules::dmx::BinaryView &, uint32_t, uint32_t)>([](lua::State *l, pragma::modules::dmx::BinaryView &view, uint32_t offset, uint32_t size) {
+		auto slice = view.Slice(offset, size);
+		if(!slice.has_value())
+			return;
+		Lua::PushString(l, std::string {reinterpret_cast<const char *>(slice->GetData()), slice->GetSize()});
+	}));
+	auto defRead = [&classDefBinaryView]<typename T>(const char *name) {
+		classDefBinaryView.def(name, static_cast<void (*)(lua::State *, pragma::modules::dmx::BinaryView &, uint32_t)>([](lua::State *l, pragma::modules::dmx::BinaryView &view, uint32_t offset) {
+			auto value = view.Read<T>(offset);
+			if(!value.has_value())
+				return;
+			if constexpr(std::is_floating_point_v<T>)
+				Lua::PushNumber(l, *value);
+			else
+				Lua::PushInt(l, *value);
+		}));
+	};
+	defRead.template operator()<uint8_t>("ReadUInt8");
+	defRead.template operator()<int8_t>("ReadInt8");
+	defRead.template operator()<uint16_t>("ReadUInt16");
+	defRead.template operator()<int16_t>("ReadInt16");
+	defRead.template operator()<uint32_t>("ReadUInt32");
+	defRead.template operator()<int32_t>("ReadInt32");
+	defRead.template operator()<uint64_t>("ReadUInt64");
+	defRead.template operator()<int64_t>("ReadInt64");
+	defRead.template operator()<float>("ReadFloat");
+	defRead.template operator()<double>("ReadDouble");
+	modDMX[classDefBinaryView];
+
+	using pragma::modules::dmx::FrozenAttribute;
+	using pragma::modules::dmx::FrozenDocument;
+	using pragma::modules::dmx::FrozenElement;
+	auto classDefFrozenDoc = luabind::class_<FrozenDocument>("FrozenDocument");
+	classDefFrozenDoc.def("__tostring", static_cast<void (*)(lua::State *, FrozenDocument &)>([](lua::State *l, FrozenDocument &doc) {
+		Lua::PushString(l, "DMXFrozenDocument[" + std::to_string(doc.GetElementCount()) + " elements][" + pragma::util::get_pretty_bytes(doc.GetMemoryUsage()) + "]");
+	}));
+	classDefFrozenDoc.def("GetMemoryUsage", static_cast<void (*)(lua::State *, FrozenDocument &)>([](lua::State *l, FrozenDocument &doc) { Lua::PushInt(l, doc.GetMemoryUsage()); }));
+	classDefFrozenDoc.def("GetElementCount", static_cast<void (*)(lua::State *, FrozenDocument &)>([](lua::State *l, FrozenDocument &doc) { Lua::PushInt(l, doc.GetElementCount()); }));
+	classDefFrozenDoc.def("GetElement", static_cast<void (*)(lua::State *, const std::shared_ptr<FrozenDocument> &, uint32_t)>([](lua::State *l, const std::shared_ptr<FrozenDocument> &doc, uint32_t idx) {
+		if(idx == 0 || idx > doc->GetElementCount())
+			return;
+		push_frozen_element(l, doc, idx - 1);
+	}));
+	classDefFrozenDoc.def("GetElements", static_cast<void (*)(lua::State *, const std::shared_ptr<FrozenDocument> &)>([](lua::State *l, const std::shared_ptr<FrozenDocument> &doc) {
+		auto t = Lua::CreateTable(l);
+		for(auto i = decltype(doc->GetElementCount()) {0u}; i < doc->GetElementCount(); ++i) {
+			Lua::PushInt(l, i + 1);
+			push_frozen_element(l, doc, i);
+			Lua::SetTableValue(l, t);
+		}
+	}));
+	classDefFrozenDoc.def("GetRootAttribute", static_cast<void (*)(lua::State *, const std::shared_ptr<FrozenDocument> &)>([](lua::State *l, const std::shared_ptr<FrozenDocument> &doc) { push_frozen_attribute(l, doc, doc->GetRootAttribute()); }));
+	classDefFrozenDoc.def("GetRootElement", static_cast<void (*)(lua::State *, const std::shared_ptr<FrozenDocument> &)>([](lua::State *l, const std::shared_ptr<FrozenDocument> &doc) {
+		auto rootAttr = doc->GetRootAttribute();
+		if(rootAttr == FrozenDocument::INVALID_INDEX)
+			return;
+		push_frozen_element(l, doc, doc->GetReferencedElement(rootAttr));
+	}));
+	modDMX[classDefFrozenDoc];
+
+	auto classDefFrozenEl = luabind::class_<FrozenElement>("FrozenElement");
+	classDefFrozenEl.def("__tostring", static_cast<void (*)(lua::State *, FrozenElement &)>([](lua::State *l, FrozenElement &el) {
+		auto &rec = el.document->GetElement(el.index);
+		Lua::PushString(l, "DMXFrozenElement[" + el.document->GetString(rec.name) + "][" + el.document->GetString(rec.type) + "]");
+	}));
+	classDefFrozenEl.def("__eq", static_cast<void (*)(lua::State *, FrozenElement &, FrozenElement &)>([](lua::State *l, FrozenElement &el, FrozenElement &elOther) { Lua::PushBool(l, el.document == elOther.document && el.index == elOther.index); }));
+	classDefFrozenEl.def("GetGUID", static_cast<void (*)(lua::State *, FrozenElement &)>([](lua::State *l, FrozenElement &el) { Lua::PushString(l, el.document->GetString(el.document->GetElement(el.index).guid)); }));
+	classDefFrozenEl.def("GetName", static_cast<void (*)(lua::State *, FrozenElement &)>([](lua::State *l, FrozenElement &el) { Lua::PushString(l, el.document->GetString(el.document->GetElement(el.index).name)); }));
+	classDefFrozenEl.def("GetType", static_cast<void (*)(lua::State *, FrozenElement &)>([](lua::State *l, FrozenElement &el) { Lua::PushString(l, el.document->GetString(el.document->GetElement(el.index).type)); }));
+	classDefFrozenEl.def("Get", static_cast<void (*)(lua::State *, FrozenElement &, const std::string &)>([](lua::State *l, FrozenElement &el, const std::string &name) {
+		auto attrIdx = el.document->FindAttribute(el.index, name);
+		if(attrIdx == FrozenDocument::INVALID_INDEX)
+			return;
+		push_frozen_element(l, el.document, el.document->GetReferencedElement(attrIdx));
+	}));
+	auto getAttr = static_cast<void (*)(lua::State *, FrozenElement &, const std::string &)>([](lua::State *l, FrozenElement &el, const std::string &name) { push_frozen_attribute(l, el.document, el.document->FindAttribute(el.index, name)); });
+	classDefFrozenEl.def("GetAttr", getAttr);
+	classDefFrozenEl.def("GetAttribute", getAttr);
+	auto getAttrV = static_cast<void (*)(lua::State *, FrozenElement &, const std::string &)>([](lua::State *l, FrozenElement &el, const std::string &name) {
+		auto attrIdx = el.document->FindAttribute(el.index, name);
+		if(attrIdx == FrozenDocument::INVALID_INDEX)
+			return;
+		push_frozen_value(l, FrozenAttribute {el.document, attrIdx});
+	});
+	classDefFrozenEl.def("GetAttrV", getAttrV);
+	classDefFrozenEl.def("GetAttributeValue", getAttrV);
+	classDefFrozenEl.def("GetAttributes", static_cast<void (*)(lua::State *, FrozenElement &)>([](lua::State *l, FrozenElement &el) {
+		auto &rec = el.document->GetElement(el.index);
+		auto t = Lua::CreateTable(l);
+		for(auto i = rec.firstAttribute; i < rec.firstAttribute + rec.attributeCount; ++i) {
+			Lua::PushString(l, el.document->GetString(el.document->GetAttribute(i).name));
+			push_frozen_attribute(l, el.document, i);
+			Lua::SetTableValue(l, t);
+		}
+	}));
+	classDefFrozenEl.def("GetAttributeCount", static_cast<void (*)(lua::State *, FrozenElement &)>([](lua::State *l, FrozenElement &el) { Lua::PushInt(l, el.document->GetElement(el.index).attributeCount); }));
+	classDefFrozenEl.def("GetAttributeNames", static_cast<void (*)(lua::State *, FrozenElement &)>([](lua::State *l, FrozenElement &el) {
+		auto &rec = el.document->GetElement(el.index);
+		auto t = Lua::CreateTable(l);
+		auto idx = 1u;
+		for(auto i = rec.firstAttribute; i < rec.firstAttribute + rec.attributeCount; ++i) {
+			Lua::PushInt(l, idx++);
+			Lua::PushString(l, el.document->GetString(el.document->GetAttribute(i).name));
+			Lua::SetTableValue(l, t);
+		}
+	}));
+	classDefFrozenEl.def("HasAttribute", static_cast<void (*)(lua::State *, FrozenElement &, const std::string &)>([](lua::State *l, FrozenElement &el, const std::string &name) { Lua::PushBool(l, el.document->FindAttribute(el.index, name) != FrozenDocument::INVALID_INDEX); }));
+	modDMX[classDefFrozenEl];
+
+	auto classDefFrozenAttr = luabind::class_<FrozenAttribute>("FrozenAttribute");
+	classDefFrozenAttr.def("__tostring", static_cast<void (*)(lua::State *, FrozenAttribute &)>([](lua::State *l, FrozenAttribute &attr) {
+		auto &rec = attr.document->GetAttribute(attr.index);
+		std::string str = "DMXFrozenAttribute[" + attr.document->GetString(rec.name) + "][" + source_engine::dmx::type_to_string(attr.GetType()) + "]";
+		if(attr.arrayIndex >= 0)
+			str += "[" + std::to_string(attr.arrayIndex + 1) + "]";
+		Lua::PushString(l, str);
+	}));
+	classDefFrozenAttr.def("__eq", static_cast<void (*)(lua::State *, FrozenAttribute &, FrozenAttribute &)>([](lua::State *l, FrozenAttribute &attr, FrozenAttribute &attrOther) {
+		Lua::PushBool(l, attr.document == attrOther.document && attr.index == attrOther.index && attr.arrayIndex == attrOther.arrayIndex);
+	}));
+	classDefFrozenAttr.def("GetType", static_cast<void (*)(lua::State *, FrozenAttribute &)>([](lua::State *l, FrozenAttribute &attr) { Lua::PushInt(l, pragma::math::to_integral(attr.GetType())); }));
+	classDefFrozenAttr.def("IsValid", static_cast<void (*)(lua::State *, FrozenAttribute &)>([](lua::State *l, FrozenAttribute &attr) { Lua::PushBool(l, attr.GetType() != source_engine::dmx::AttrType::Invalid); }));
+	classDefFrozenAttr.def("Get", static_cast<void (*)(lua::State *, FrozenAttribute &, const std::string &)>([](lua::State *l, FrozenAttribute &attr, const std::string &name) {
+		if(attr.GetType() != source_engine::dmx::AttrType::Element)
+			return;
+		auto &rec = attr.document->GetAttribute(attr.index);
+		auto elIdx = (attr.arrayIndex < 0) ? rec.payload : *attr.document->GetElementRefs(rec.payload + attr.arrayIndex);
+		if(elIdx == FrozenDocument::INVALID_INDEX)
+			return;
+		auto attrIdx = attr.document->FindAttribute(elIdx, name);
+		if(attrIdx == FrozenDocument::INVALID_INDEX)
+			return;
+		push_frozen_element(l, attr.document, attr.document->GetReferencedElement(attrIdx));
+	}));
+	classDefFrozenAttr.def("GetValue", static_cast<void (*)(lua::State *, FrozenAttribute &)>([](lua::State *l, FrozenAttribute &attr) { push_frozen_value(l, attr); }));
+	classDefFrozenAttr.def("GetArraySize", static_cast<void (*)(lua::State *, FrozenAttribute &)>([](lua::State *l, FrozenAttribute &attr) {
+		if(attr.arrayIndex >= 0 || !pragma::modules::dmx::is_array_type(attr.GetType()))
+			return;
+		Lua::PushInt(l, attr.document->GetAttribute(attr.index).count);
+	}));
+	classDefFrozenAttr.def("GetArrayData", static_cast<void (*)(lua::State *, FrozenAttribute &)>([](lua::State *l, FrozenAttribute &attr) {
+		if(attr.arrayIndex >= 0)
+			return;
+		auto &rec = attr.document->GetAttribute(attr.index);
+		auto layout = pragma::modules::dmx::get_array_layout(rec.type);
+		if(!layout.has_value() || rec.payload == FrozenDocument::INVALID_INDEX)
+			return;
+		// The payload is stored with the packed layout already, so this is a single copy
+		const uint8_t *data = nullptr;
+		switch(layout->componentType) {
+		case pragma::modules::dmx::ComponentType::Float:
+			data = reinterpret_cast<const uint8_t *>(attr.document->GetFloats(rec.payload));
+			break;
+		case pragma::modules::dmx::ComponentType::Int32:
+			data = reinterpret_cast<const uint8_t *>(attr.document->GetInts(rec.payload));
+			break;
+		case pragma::modules::dmx::ComponentType::UInt8:
+			data = attr.document->GetBytes(rec.payload);
+			break;
+		default:
+			return;
+		}
+		auto size = rec.count * layout->GetEntrySize();
+		pragma::util::DataStream ds(size);
+		if(size > 0)
+			ds->Write(data, size);
+		ds->SetOffset(0);
+		Lua::Push<pragma::util::DataStream>(l, ds);
+		Lua::PushInt(l, rec.count);
+	}));
+	modDMX[classDefFrozenAttr];
+
 	auto classDefAttribute = luabind::class_<source_engine::dmx::Attribute>("Attribute");
 	classDefAttribute.add_static_constant("TYPE_NONE", pragma::math::to_integral(source_engine::dmx::AttrType::None));
 	classDefAttribute.add_static_constant("TYPE_ELEMENT", pragma::math::to_integral(source_engine::dmx::AttrType::Element));
@@ -331,13 +1474,21 @@ void Lua::dmx::register_lua_library(Lua::Interface &l)
 	classDefAttribute.add_static_constant("TYPE_INVALID", pragma::math::to_integral(source_engine::dmx::AttrType::Invalid));
 
 	classDefAttribute.def("__tostring", static_cast<void (*)(lua::State *, source_engine::dmx::Attribute &)>([](lua::State *l, source_engine::dmx::Attribute &attr) {
-		std::stringstream ss;
-		attr.DebugPrint(ss);
-		Lua::PushString(l, ss.str());
+		pragma::modules::dmx::increment_counter(pragma::modules::dmx::Counter::ToString);
+		push_dump(l, attr, get_tostring_dump_options());
+		Lua::Pop(l, 1);
 	}));
+	classDefAttribute.def("Dump", static_cast<void (*)(lua::State *, source_engine::dmx::Attribute &)>([](lua::State *l, source_engine::dmx::Attribute &attr) { push_dump(l, attr, {}); }));
+	classDefAttribute.def("Dump", static_cast<void (*)(lua::State *, source_engine::dmx::Attribute &, luabind::object)>([](lua::State *l, source_engine::dmx::Attribute &attr, luabind::object oOptions) { push_dump(l, attr, read_dump_options(l, 2)); }));
 	classDefAttribute.def("__eq", static_cast<void (*)(lua::State *, source_engine::dmx::Attribute &, source_engine::dmx::Attribute &)>([](lua::State *l, source_engine::dmx::Attribute &attr, source_engine::dmx::Attribute &attrOther) { Lua::PushBool(l, &attr == &attrOther); }));
 	classDefAttribute.def("GetType", static_cast<void (*)(lua::State *, source_engine::dmx::Attribute &)>([](lua::State *l, source_engine::dmx::Attribute &attr) { Lua::PushInt(l, pragma::math::to_integral(attr.type)); }));
 	classDefAttribute.def("Get", static_cast<void (*)(lua::State *, source_engine::dmx::Attribute &, const std::string &)>([](lua::State *l, source_engine::dmx::Attribute &el, const std::string &name) {
+		pragma::modules::dmx::increment_counter(pragma::modules::dmx::Counter::Get);
+		if(el.type == source_engine::dmx::AttrType::Element && el.data != nullptr) {
+			auto child = static_cast<std::weak_ptr<source_engine::dmx::Element> *>(el.data.get())->lock();
+			if(child != nullptr)
+				pragma::modules::dmx::materialize(child);
+		}
 		auto child = el.Get(name);
 		if(child == nullptr)
 			return;
@@ -347,6 +1498,58 @@ void Lua::dmx::register_lua_library(Lua::Interface &l)
 	classDefAttribute.def("AddArrayValue", static_cast<void (*)(lua::State *, source_engine::dmx::Attribute &, source_engine::dmx::Attribute &)>([](lua::State *l, source_engine::dmx::Attribute &attr, source_engine::dmx::Attribute &val) { attr.AddArrayValue(val); }));
 	classDefAttribute.def("RemoveArrayValue", static_cast<void (*)(lua::State *, source_engine::dmx::Attribute &, source_engine::dmx::Attribute &)>([](lua::State *l, source_engine::dmx::Attribute &attr, source_engine::dmx::Attribute &val) { attr.RemoveArrayValue(val); }));
 	classDefAttribute.def("GetValue", static_cast<void (*)(lua::State *, source_engine::dmx::Attribute &)>([](lua::State *l, source_engine::dmx::Attribute &attr) { push_attribute_value(l, attr); }));
+	classDefAttribute.def("GetValue", static_cast<void (*)(lua::State *, source_engine::dmx::Attribute &, bool)>([](lua::State *l, source_engine::dmx::Attribute &attr, bool copyBinary) { push_attribute_value(l, attr, copyBinary); }));
+	classDefAttribute.def("GetBinaryData", static_cast<void (*)(lua::State *, source_engine::dmx::Attribute &)>([](lua::State *l, source_engine::dmx::Attribute &attr) {
+		auto view = pragma::modules::dmx::BinaryView::Create(attr);
+		if(!view.has_value())
+			return;
+		Lua::Push<pragma::util::DataStream>(l, view->ToDataStream());
+	}));
+	classDefAttribute.def("GetArrayData", static_cast<void (*)(lua::State *, source_engine::dmx::Attribute &)>([](lua::State *l, source_engine::dmx::Attribute &attr) {
+		auto *values = pragma::modules::dmx::get_array_values(attr);
+		auto layout = pragma::modules::dmx::get_array_layout(attr.type);
+		if(values == nullptr || !layout.has_value())
+			return;
+		pragma::util::DataStream ds(values->size() * layout->GetEntrySize());
+		auto n = pragma::modules::dmx::pack_array(attr, ds);
+		ds->SetOffset(0);
+		Lua::Push<pragma::util::DataStream>(l, ds);
+		Lua::PushInt(l, *n);
+	}));
+	classDefAttribute.def("GetArrayValuesInto", static_cast<void (*)(lua::State *, source_engine::dmx::Attribute &, pragma::util::DataStream &)>([](lua::State *l, source_engine::dmx::Attribute &attr, pragma::util::DataStream &ds) {
+		auto n = pragma::modules::dmx::pack_array(attr, ds);
+		if(!n.has_value())
+			return;
+		Lua::PushInt(l, *n);
+	}));
+	classDefAttribute.def("GetArrayValues", static_cast<void (*)(lua::State *, source_engine::dmx::Attribute &)>([](lua::State *l, source_engine::dmx::Attribute &attr) {
+		auto *values = pragma::modules::dmx::get_array_values(attr);
+		if(values == nullptr)
+			return;
+		switch(attr.type) {
+		case source_engine::dmx::AttrType::IntArray:
+		case source_engine::dmx::AttrType::FloatArray:
+		case source_engine::dmx::AttrType::TimeArray:
+		case source_engine::dmx::AttrType::BoolArray:
+			break;
+		default:
+			return;
+		}
+		auto t = Lua::CreateTable(l);
+		auto idx = 1u;
+		for(auto &subAttr : *values) {
+			Lua::PushInt(l, idx++);
+			if(subAttr == nullptr || subAttr->data == nullptr)
+				Lua::PushNil(l);
+			else if(attr.type == source_engine::dmx::AttrType::IntArray)
+				Lua::PushInt(l, *static_cast<int32_t *>(subAttr->data.get()));
+			else if(attr.type == source_engine::dmx::AttrType::BoolArray)
+				Lua::PushBool(l, *static_cast<bool *>(subAttr->data.get()));
+			else
+				Lua::PushNumber(l, *static_cast<float *>(subAttr->data.get()));
+			Lua::SetTableValue(l, t);
+		}
+	}));
 	classDefAttribute.def("GetValueAsString", static_cast<void (*)(lua::State *, source_engine::dmx::Attribute &)>([](lua::State *l, source_engine::dmx::Attribute &attr) {
 		if(attr.data == nullptr) {
 			Lua::PushString(l, "");
@@ -0,0 +1,93 @@
+// SPDX-FileCopyrightText: (c) 2020 Silverlan <opensource@pragma-engine.com>
+// SPDX-License-Identifier: MIT
+
+module;
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+module pragma.modules.dmx;
+
+import :mapped_file;
+
+std::unique_ptr<pragma::modules::dmx::MappedFile> pragma::modules::dmx::MappedFile::Open(const std::string &absPath, std::string &outErr)
+{
+	auto mf = std::unique_ptr<MappedFile> {new MappedFile {}};
+#ifdef _WIN32
+	auto hFile = CreateFileA(absPath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if(hFile == INVALID_HANDLE_VALUE) {
+		outErr = "Unable to open file '" + absPath + "'!";
+		return nullptr;
+	}
+	mf->m_fileHandle = hFile;
+	LARGE_INTEGER size;
+	if(GetFileSizeEx(hFile, &size) == FALSE) {
+		outErr = "Unable to determine size of file '" + absPath + "'!";
+		return nullptr;
+	}
+	mf->m_size = static_cast<size_t>(size.QuadPart);
+	if(mf->m_size == 0)
+		return mf;
+	auto hMapping = CreateFileMappingA(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if(hMapping == nullptr) {
+		outErr = "Unable to create file mapping for '" + absPath + "'!";
+		return nullptr;
+	}
+	mf->m_mappingHandle = hMapping;
+	auto *data = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+	if(data == nullptr) {
+		outErr = "Unable to map file '" + absPath + "'!";
+		return nullptr;
+	}
+	mf->m_data = static_cast<const uint8_t *>(data);
+#else
+	auto fd = ::open(absPath.c_str(), O_RDONLY);
+	if(fd == -1) {
+		outErr = "Unable to open file '" + absPath + "'!";
+		return nullptr;
+	}
+	struct stat st {};
+	if(fstat(fd, &st) != 0) {
+		::close(fd);
+		outErr = "Unable to determine size of file '" + absPath + "'!";
+		return nullptr;
+	}
+	mf->m_size = static_cast<size_t>(st.st_size);
+	if(mf->m_size == 0) {
+		::close(fd);
+		return mf;
+	}
+	auto *data = mmap(nullptr, mf->m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	// The mapping stays valid after the descriptor has been closed
+	::close(fd);
+	if(data == MAP_FAILED) {
+		outErr = "Unable to map file '" + absPath + "'!";
+		return nullptr;
+	}
+	// The parser reads the file front to back
+	madvise(data, mf->m_size, MADV_SEQUENTIAL);
+	mf->m_data = static_cast<const uint8_t *>(data);
+#endif
+	return mf;
+}
+
+pragma::modules::dmx::MappedFile::~MappedFile()
+{
+#ifdef _WIN32
+	if(m_data)
+		UnmapViewOfFile(m_data);
+	if(m_mappingHandle)
+		CloseHandle(m_mappingHandle);
+	if(m_fileHandle)
+		CloseHandle(m_fileHandle);
+#else
+	if(m_data)
+		munmap(const_cast<uint8_t *>(m_data), m_size);
+#endif
+}
@@ -0,0 +1,369 @@
+// SPDX-FileCopyrightText: (c) 2020 Silverlan <opensource@pragma-engine.com>
+// SPDX-License-Identifier: MIT
+
+module pragma.modules.dmx;
+
+import :arrays;
+import :lazy;
+import :mesh;
+import :thread_pool;
+
+static source_engine::dmx::Attribute *find_attribute(const std::shared_ptr<source_engine::dmx::Element> &el, const std::string &name)
+{
+	pragma::modules::dmx::materialize(el);
+	auto it = el->attributes.find(name);
+	return (it != el->attributes.end()) ? it->second.get() : nullptr;
+}
+
+static std::shared_ptr<source_engine::dmx::Element> get_element(const source_engine::dmx::Attribute *attr)
+{
+	if(attr == nullptr || attr->type != source_engine::dmx::AttrType::Element || attr->data == nullptr)
+		return nullptr;
+	return static_cast<std::weak_ptr<source_engine::dmx::Element> *>(attr->data.get())->lock();
+}
+
+template<typename T>
+static bool read_array(const source_engine::dmx::Attribute *attr, source_engine::dmx::AttrType expectedType, std::vector<T> &outValues, uint32_t &outComponentCount)
+{
+	if(attr == nullptr)
+		return false;
+	auto *values = pragma::modules::dmx::get_array_values(*attr);
+	auto layout = pragma::modules::dmx::get_array_layout(attr->type);
+	if(values == nullptr || !layout.has_value() || layout->GetComponentSize() != sizeof(T))
+		return false;
+	if(expectedType != source_engine::dmx::AttrType::Invalid && attr->type != expectedType)
+		return false;
+	outComponentCount = layout->componentCount;
+	outValues.resize(values->size() * layout->componentCount);
+	pragma::modules::dmx::pack_array(*values, attr->type, reinterpret_cast<uint8_t *>(outValues.data()));
+	return true;
+}
+
+static bool read_floats(const source_engine::dmx::Attribute *attr, std::vector<float> &outValues, uint32_t &outComponentCount)
+{
+	auto layout = attr ? pragma::modules::dmx::get_array_layout(attr->type) : std::nullopt;
+	if(!layout.has_value() || layout->componentType != pragma::modules::dmx::ComponentType::Float)
+		return false;
+	return read_array(attr, source_engine::dmx::AttrType::Invalid, outValues, outComponentCount);
+}
+
+static bool read_ints(const source_engine::dmx::Attribute *attr, std::vector<int32_t> &outValues)
+{
+	uint32_t componentCount;
+	return read_array(attr, source_engine::dmx::AttrType::IntArray, outValues, componentCount);
+}
+
+std::vector<std::shared_ptr<source_engine::dmx::Element>> pragma::modules::dmx::find_meshes(const std::shared_ptr<source_engine::dmx::Element> &root)
+{
+	std::vector<std::shared_ptr<source_engine::dmx::Element>> meshes;
+	if(root == nullptr)
+		return meshes;
+	std::unordered_set<const source_engine::dmx::Element *> visited;
+	std::queue<std::shared_ptr<source_engine::dmx::Element>> queue;
+	queue.push(root);
+	visited.insert(root.get());
+	auto enqueue = [&visited, &queue](const source_engine::dmx::Attribute *attr) {
+		auto el = get_element(attr);
+		if(el && visited.insert(el.get()).second)
+			queue.push(el);
+	};
+	while(!queue.empty()) {
+		auto el = std::move(queue.front());
+		queue.pop();
+		if(el->type == "DmeMesh") {
+			// Vertex data and face sets do not contain any further meshes
+			meshes.push_back(el);
+			continue;
+		}
+		pragma::modules::dmx::materialize(el);
+		for(auto &pair : el->attributes) {
+			auto &attr = pair.second;
+			if(attr == nullptr)
+				continue;
+			if(attr->type == source_engine::dmx::AttrType::Element)
+				enqueue(attr.get());
+			else if(auto *values = get_array_values(*attr); values && attr->type == source_engine::dmx::AttrType::ElementArray) {
+				for(auto &val : *values)
+					enqueue(val.get());
+			}
+		}
+	}
+	return meshes;
+}
+
+namespace {
+	// A face-vertex is identified by its index into every stream. Hashing the tuples in place avoids building a key per face-vertex.
+	struct FaceVertexHash {
+		const int32_t *tuples;
+		size_t tupleSize;
+		size_t operator()(uint32_t fv) const
+		{
+			size_t hash = 0;
+			auto *t = tuples + fv * tupleSize;
+			for(size_t i = 0; i < tupleSize; ++i)
+				hash ^= std::hash<int32_t> {}(t[i]) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+			return hash;
+		}
+	};
+	struct FaceVertexEqual {
+		const int32_t *tuples;
+		size_t tupleSize;
+		bool operator()(uint32_t a, uint32_t b) const { return std::equal(tuples + a * tupleSize, tuples + (a + 1) * tupleSize, tuples + b * tupleSize); }
+	};
+
+	struct StreamData {
+		pragma::modules::dmx::MeshStream info;
+		std::vector<float> values;
+		std::vector<int32_t> indices;
+	};
+};
+
+bool pragma::modules::dmx::extract_mesh(const std::shared_ptr<source_engine::dmx::Element> &mesh, const MeshLayout &layout, ExtractedMesh &outMesh, std::string &outErr)
+{
+	outMesh.mesh = mesh;
+	auto vertexData = get_element(find_attribute(mesh, "bindState"));
+	if(vertexData == nullptr)
+		vertexData = get_element(find_attribute(mesh, "currentState"));
+	if(vertexData == nullptr) {
+		outErr = "Mesh '" + mesh->name + "' has no vertex data";
+		return false;
+	}
+
+	auto streamNames = layout.streams;
+	if(streamNames.empty()) {
+		auto *format = find_attribute(vertexData, "vertexFormat");
+		auto *formatValues = format ? get_array_values(*format) : nullptr;
+		if(formatValues) {
+			for(auto &val : *formatValues) {
+				if(val == nullptr || val->type != source_engine::dmx::AttrType::String || val->data == nullptr)
+					continue;
+				auto &name = *static_cast<std::string *>(val->data.get());
+				auto *attr = find_attribute(vertexData, name);
+				auto streamLayout = attr ? get_array_layout(attr->type) : std::nullopt;
+				if(name != "jointWeights" && name != "jointIndices" && streamLayout.has_value() && streamLayout->componentType == ComponentType::Float)
+					streamNames.push_back(name);
+			}
+		}
+	}
+
+	if(streamNames.empty()) {
+		outErr = "Mesh '" + mesh->name + "' has no vertex streams";
+		return false;
+	}
+
+	// Read all streams up front, every stream has its own face-vertex index array
+	std::vector<StreamData> streams;
+	streams.reserve(streamNames.size());
+	uint32_t stride = 0;
+	std::optional<size_t> faceVertexCount {};
+	for(auto &name : streamNames) {
+		StreamData stream {};
+		stream.info.name = name;
+		auto *attr = find_attribute(vertexData, name);
+		if(!read_floats(attr, stream.values, stream.info.componentCount)) {
+			outErr = "Mesh '" + mesh->name + "' has no float stream '" + name + "'";
+			return false;
+		}
+		stream.info.type = get_array_entry_type(attr->type);
+		if(!read_ints(find_attribute(vertexData, name + "Indices"), stream.indices)) {
+			outErr = "Mesh '" + mesh->name + "' has no index array for stream '" + name + "'";
+			return false;
+		}
+		if(faceVertexCount.has_value() && *faceVertexCount != stream.indices.size()) {
+			outErr = "Index array of stream '" + name + "' of mesh '" + mesh->name + "' has a different length than the other streams";
+			return false;
+		}
+		faceVertexCount = stream.indices.size();
+		auto numValues = stream.values.size() / stream.info.componentCount;
+		for(auto idx : stream.indices) {
+			if(idx < 0 || static_cast<size_t>(idx) >= numValues) {
+				outErr = "Stream '" + name + "' of mesh '" + mesh->name + "' has an out-of-range index " + std::to_string(idx);
+				return false;
+			}
+		}
+		stream.info.offset = stride;
+		stride += stream.info.componentCount * sizeof(float);
+		streams.push_back(std::move(stream));
+	}
+	auto numFaceVertices = faceVertexCount.value_or(0);
+
+	// Map face-vertices to output vertices
+	std::vector<uint32_t> faceVertexToVertex(numFaceVertices);
+	std::vector<uint32_t> vertexToFaceVertex;
+	if(layout.weld) {
+		std::vector<int32_t> tuples(numFaceVertices * streams.size());
+		for(size_t fv = 0; fv < numFaceVertices; ++fv) {
+			for(size_t s = 0; s < streams.size(); ++s)
+				tuples[fv * streams.size() + s] = streams[s].indices[fv];
+		}
+		std::unordered_map<uint32_t, uint32_t, FaceVertexHash, FaceVertexEqual> vertexIds {numFaceVertices, FaceVertexHash {tuples.data(), streams.size()}, FaceVertexEqual {tuples.data(), streams.size()}};
+		for(uint32_t fv = 0; fv < numFaceVertices; ++fv) {
+			auto [it, inserted] = vertexIds.emplace(fv, static_cast<uint32_t>(vertexToFaceVertex.size()));
+			if(inserted)
+				vertexToFaceVertex.push_back(fv);
+			faceVertexToVertex[fv] = it->second;
+		}
+	}
+	else {
+		vertexToFaceVertex.resize(numFaceVertices);
+		std::iota(vertexToFaceVertex.begin(), vertexToFaceVertex.end(), 0u);
+		std::iota(faceVertexToVertex.begin(), faceVertexToVertex.end(), 0u);
+	}
+
+	// Interleave the vertex streams
+	auto vertexBufferSize = static_cast<uint64_t>(vertexToFaceVertex.size()) * stride;
+	if(vertexBufferSize > std::numeric_limits<uint32_t>::max()) {
+		outErr = "Vertex data of mesh '" + mesh->name + "' exceeds the maximum buffer size";
+		return false;
+	}
+	outMesh.vertexStride = stride;
+	outMesh.vertexCount = static_cast<uint32_t>(vertexToFaceVertex.size());
+	outMesh.vertices = pragma::util::DataStream(static_cast<uint32_t>(vertexBufferSize));
+	for(auto fv : vertexToFaceVertex) {
+		for(auto &stream : streams) {
+			auto n = stream.info.componentCount;
+			outMesh.vertices->Write(reinterpret_cast<const uint8_t *>(stream.values.data() + stream.indices[fv] * n), n * sizeof(float));
+		}
+	}
+	outMesh.vertices->SetOffset(0);
+	outMesh.streams.reserve(streams.size());
+	for(auto &stream : streams)
+		outMesh.streams.push_back(std::move(stream.info));
+
+	// Triangulate the face sets. Triangle meshes have one index per face-vertex, which is used as the initial capacity.
+	outMesh.indices = pragma::util::DataStream(static_cast<uint32_t>(std::min<uint64_t>(numFaceVertices * sizeof(uint32_t), std::numeric_limits<uint32_t>::max())));
+	auto *faceSets = find_attribute(mesh, "faceSets");
+	auto *faceSetValues = faceSets ? get_array_values(*faceSets) : nullptr;
+	if(faceSetValues) {
+		std::vector<int32_t> faces;
+		std::vector<uint32_t> polygon;
+		for(auto &val : *faceSetValues) {
+			auto faceSet = get_element(val.get());
+			if(faceSet == nullptr)
+				continue;
+			MeshFaceSet range {};
+			range.material = get_element(find_attribute(faceSet, "material"));
+			range.firstIndex = outMesh.indexCount;
+			faces.clear();
+			read_ints(find_attribute(faceSet, "faces"), faces);
+			// Count the indices first, so the buffer grows at most once per face set
+			uint64_t numIndices = 0;
+			size_t polygonSize = 0;
+			for(size_t i = 0; i <= faces.size(); ++i) {
+				if(i < faces.size() && faces[i] >= 0) {
+					++polygonSize;
+					continue;
+				}
+				if(polygonSize > 2)
+					numIndices += (polygonSize - 2) * 3;
+				polygonSize = 0;
+			}
+			if((outMesh.indexCount + numIndices) * sizeof(uint32_t) > std::numeric_limits<uint32_t>::max()) {
+				outErr = "Index data of mesh '" + mesh->name + "' exceeds the maximum buffer size";
+				return false;
+			}
+			outMesh.indices->Reserve(static_cast<uint32_t>((outMesh.indexCount + numIndices) * sizeof(uint32_t)));
+			// Polygons are lists of face-vertex indices terminated by -1
+			polygon.clear();
+			for(size_t i = 0; i <= faces.size(); ++i) {
+				auto idx = (i < faces.size()) ? faces[i] : -1;
+				if(idx >= 0) {
+					if(static_cast<size_t>(idx) >= numFaceVertices) {
+						outErr = "Face set '" + faceSet->name + "' of mesh '" + mesh->name + "' refers to non-existent face-vertex " + std::to_string(idx);
+						return false;
+					}
+					polygon.push_back(faceVertexToVertex[idx]);
+					continue;
+				}
+				for(size_t j = 2; j < polygon.size(); ++j) {
+					std::array<uint32_t, 3> triangle {polygon[0], polygon[j - 1], polygon[j]};
+					outMesh.indices->Write(reinterpret_cast<const uint8_t *>(triangle.data()), sizeof(triangle));
+				}
+				outMesh.indexCount += static_cast<uint32_t>((polygon.size() > 2) ? (polygon.size() - 2) * 3 : 0);
+				polygon.clear();
+			}
+			range.indexCount = outMesh.indexCount - range.firstIndex;
+			outMesh.faceSets.push_back(range);
+		}
+	}
+	outMesh.indices->SetOffset(0);
+
+	// Bone weights are stored per position, not per face-vertex
+	if(!layout.boneWeights)
+		return true;
+	auto *jointCountAttr = find_attribute(vertexData, "jointCount");
+	if(jointCountAttr == nullptr || jointCountAttr->type != source_engine::dmx::AttrType::Int || jointCountAttr->data == nullptr)
+		return true;
+	auto jointCount = *static_cast<int32_t *>(jointCountAttr->data.get());
+	std::vector<float> weights;
+	std::vector<int32_t> jointIndices;
+	std::vector<int32_t> positionIndices;
+	uint32_t weightComponents;
+	if(jointCount <= 0 || !read_floats(find_attribute(vertexData, "jointWeights"), weights, weightComponents) || !read_ints(find_attribute(vertexData, "jointIndices"), jointIndices)
+	  || !read_ints(find_attribute(vertexData, "positionsIndices"), positionIndices))
+		return true;
+	if(static_cast<uint32_t>(jointCount) > ExtractedMesh::MAX_JOINT_COUNT) {
+		outErr = "Mesh '" + mesh->name + "' has " + std::to_string(jointCount) + " joints per vertex, at most " + std::to_string(ExtractedMesh::MAX_JOINT_COUNT) + " are supported";
+		return false;
+	}
+	// There are exactly jointCount weights and joint indices per position
+	auto *positions = find_attribute(vertexData, "positions");
+	auto *positionValues = positions ? get_array_values(*positions) : nullptr;
+	auto positionCount = positionValues ? positionValues->size() : 0;
+	if(positionIndices.size() != numFaceVertices || weights.size() != positionCount * jointCount || jointIndices.size() != weights.size()) {
+		outErr = "Joint weight and index arrays of mesh '" + mesh->name + "' do not match its " + std::to_string(positionCount) + " positions with " + std::to_string(jointCount) + " joints each";
+		return false;
+	}
+	auto weightBufferSize = static_cast<uint64_t>(outMesh.vertexCount) * jointCount * (sizeof(int32_t) + sizeof(float));
+	if(weightBufferSize > std::numeric_limits<uint32_t>::max()) {
+		outErr = "Bone weights of mesh '" + mesh->name + "' exceed the maximum buffer size";
+		return false;
+	}
+	outMesh.boneWeights = pragma::util::DataStream(static_cast<uint32_t>(weightBufferSize));
+	for(auto fv : vertexToFaceVertex) {
+		auto positionIdx = positionIndices[fv];
+		if(positionIdx < 0 || static_cast<size_t>(positionIdx) >= positionCount) {
+			outErr = "Mesh '" + mesh->name + "' has an out-of-range position index " + std::to_string(positionIdx);
+			return false;
+		}
+		auto base = static_cast<size_t>(positionIdx) * jointCount;
+		for(auto j = 0; j < jointCount; ++j) {
+			outMesh.boneWeights->Write(reinterpret_cast<const uint8_t *>(&jointIndices[base + j]), sizeof(int32_t));
+			outMesh.boneWeights->Write(reinterpret_cast<const uint8_t *>(&weights[base + j]), sizeof(float));
+		}
+	}
+	outMesh.boneWeights->SetOffset(0);
+	outMesh.jointCount = static_cast<uint32_t>(jointCount);
+	return true;
+}
+
+std::optional<std::vector<pragma::modules::dmx::ExtractedMesh>> pragma::modules::dmx::extract_meshes(const std::vector<std::shared_ptr<source_engine::dmx::Element>> &meshes, const MeshLayout &layout, std::string &outErr)
+{
+	std::vector<ExtractedMesh> results(meshes.size());
+	std::vector<std::string> errors(meshes.size());
+	std::vector<uint8_t> success(meshes.size(), 0);
+	auto threadCount = (layout.threadCount > 0) ? layout.threadCount : get_default_thread_count();
+	parallel_for(meshes.size(), threadCount, [&](size_t i) {
+		if(meshes[i] == nullptr) {
+			errors[i] = "Invalid mesh element";
+			return;
+		}
+		// Nothing may escape parallel_for, which would rethrow it into the caller (and possibly into Lua)
+		try {
+			success[i] = extract_mesh(meshes[i], layout, results[i], errors[i]) ? 1 : 0;
+		}
+		catch(const std::bad_alloc &) {
+			errors[i] = "Out of memory while extracting mesh '" + meshes[i]->name + "'";
+		}
+		catch(const std::exception &e) {
+			errors[i] = "Unable to extract mesh '" + meshes[i]->name + "': " + e.what();
+		}
+	});
+	for(size_t i = 0; i < meshes.size(); ++i) {
+		if(success[i] == 0) {
+			outErr = errors[i];
+			return {};
+		}
+	}
+	return results;
+}
@@ -5,4 +5,5 @@ import pragma.modules.dmx;
 
 extern "C" {
 void PR_EXPORT pragma_initialize_lua(Lua::Interface &l) { Lua::dmx::register_lua_library(l); }
+void PR_EXPORT pragma_terminate_lua(Lua::Interface &l) { Lua::dmx::unregister_lua_library(l); }
 };
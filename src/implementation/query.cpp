@@ -0,0 +1,167 @@
+// SPDX-FileCopyrightText: (c) 2020 Silverlan <opensource@pragma-engine.com>
+// SPDX-License-Identifier: MIT
+
+module pragma.modules.dmx;
+
+import :lazy;
+import :query;
+
+std::shared_ptr<pragma::modules::dmx::Query> pragma::modules::dmx::Query::Compile(const std::string &query, std::string &outErr)
+{
+	auto q = std::shared_ptr<Query> {new Query {}};
+	q->m_source = query;
+	std::string_view remaining {query};
+	while(!remaining.empty()) {
+		auto end = remaining.find('/');
+		auto segment = remaining.substr(0, end);
+		remaining = (end == std::string_view::npos) ? std::string_view {} : remaining.substr(end + 1);
+		if(end != std::string_view::npos && remaining.empty()) {
+			outErr = "Query must not end with '/'";
+			return nullptr;
+		}
+
+		Step step {};
+		auto predStart = segment.find('[');
+		step.name = segment.substr(0, predStart);
+		if(step.name.empty()) {
+			outErr = "Empty step in query '" + query + "'";
+			return nullptr;
+		}
+		step.wildcard = (step.name == "*");
+		if(!step.wildcard && std::all_of(step.name.begin(), step.name.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+			auto idx = std::strtoul(step.name.c_str(), nullptr, 10);
+			if(idx > 0)
+				step.index = static_cast<uint32_t>(idx - 1);
+		}
+
+		auto preds = (predStart == std::string_view::npos) ? std::string_view {} : segment.substr(predStart);
+		while(!preds.empty()) {
+			auto close = preds.find(']');
+			if(preds.front() != '[' || close == std::string_view::npos) {
+				outErr = "Malformed predicate in step '" + std::string {segment} + "'";
+				return nullptr;
+			}
+			auto pred = preds.substr(1, close - 1);
+			preds = preds.substr(close + 1);
+			auto sep = pred.find('=');
+			if(sep == std::string_view::npos) {
+				outErr = "Expected '=' in predicate '" + std::string {pred} + "'";
+				return nullptr;
+			}
+			auto key = pred.substr(0, sep);
+			Predicate predicate {};
+			if(key == "type")
+				predicate.kind = Predicate::Kind::Type;
+			else if(key == "name")
+				predicate.kind = Predicate::Kind::Name;
+			else {
+				outErr = "Unknown predicate '" + std::string {key} + "', expected 'type' or 'name'";
+				return nullptr;
+			}
+			predicate.value = pred.substr(sep + 1);
+			step.predicates.push_back(std::move(predicate));
+		}
+		q->m_steps.push_back(std::move(step));
+	}
+	if(q->m_steps.empty()) {
+		outErr = "Query is empty";
+		return nullptr;
+	}
+	return q;
+}
+
+static bool matches_predicates(const pragma::modules::dmx::Query::Step &step, const source_engine::dmx::Element &el)
+{
+	for(auto &pred : step.predicates) {
+		auto &value = (pred.kind == pragma::modules::dmx::Query::Predicate::Kind::Type) ? el.type : el.name;
+		if(value != pred.value)
+			return false;
+	}
+	return true;
+}
+
+namespace {
+	// Walks the steps depth-first, so that Run can stop as soon as it has found enough matches instead of
+	// expanding the whole frontier of every step first. Every step has its own visited set, which yields
+	// the same matches in the same order as a breadth-first walk.
+	class QueryRunner {
+	  public:
+		using Step = pragma::modules::dmx::Query::Step;
+		using Match = pragma::modules::dmx::Query::Match;
+		QueryRunner(const std::vector<Step> &steps, size_t maxResults) : m_steps {steps}, m_maxResults {maxResults}, m_visited(steps.size()) {}
+		std::vector<Match> Run(const std::shared_ptr<source_engine::dmx::Element> &root)
+		{
+			if(m_maxResults > 0)
+				ApplyToElement(0, root);
+			return std::move(m_results);
+		}
+	  private:
+		bool IsDone() const { return m_results.size() >= m_maxResults; }
+		void ApplyToElement(size_t stepIdx, const std::shared_ptr<source_engine::dmx::Element> &el)
+		{
+			pragma::modules::dmx::materialize(el);
+			auto &step = m_steps[stepIdx];
+			if(step.wildcard) {
+				for(auto &pair : el->attributes) {
+					Add(stepIdx, pair.second);
+					if(IsDone())
+						return;
+				}
+				return;
+			}
+			auto it = el->attributes.find(step.name);
+			if(it != el->attributes.end())
+				Add(stepIdx, it->second);
+		}
+		void ApplyToAttribute(size_t stepIdx, source_engine::dmx::Attribute &attr)
+		{
+			if(attr.data == nullptr || attr.type < source_engine::dmx::AttrType::ArrayFirst || attr.type > source_engine::dmx::AttrType::ArrayLast)
+				return;
+			auto &step = m_steps[stepIdx];
+			auto &vdata = *static_cast<std::vector<std::shared_ptr<source_engine::dmx::Attribute>> *>(attr.data.get());
+			if(step.wildcard) {
+				for(auto &subAttr : vdata) {
+					Add(stepIdx, subAttr);
+					if(IsDone())
+						return;
+				}
+				return;
+			}
+			if(step.index.has_value() && *step.index < vdata.size())
+				Add(stepIdx, vdata[*step.index]);
+		}
+		// Checks whether the attribute (or the element it refers to) is matched by the step and continues with the next step
+		void Add(size_t stepIdx, const std::shared_ptr<source_engine::dmx::Attribute> &attr)
+		{
+			if(attr == nullptr)
+				return;
+			auto &step = m_steps[stepIdx];
+			auto &visited = m_visited[stepIdx];
+			if(attr->type == source_engine::dmx::AttrType::Element) {
+				if(attr->data == nullptr)
+					return;
+				auto el = static_cast<std::weak_ptr<source_engine::dmx::Element> *>(attr->data.get())->lock();
+				if(el == nullptr || !matches_predicates(step, *el) || !visited.insert(el.get()).second)
+					return;
+				if(stepIdx + 1 == m_steps.size())
+					m_results.push_back(el);
+				else
+					ApplyToElement(stepIdx + 1, el);
+				return;
+			}
+			if(!step.predicates.empty() || !visited.insert(attr.get()).second)
+				return;
+			if(stepIdx + 1 == m_steps.size())
+				m_results.push_back(attr);
+			else
+				ApplyToAttribute(stepIdx + 1, *attr);
+		}
+
+		const std::vector<Step> &m_steps;
+		size_t m_maxResults;
+		std::vector<std::unordered_set<const void *>> m_visited;
+		std::vector<Match> m_results;
+	};
+};
+
+std::vector<pragma::modules::dmx::Query::Match> pragma::modules::dmx::Query::Run(const std::shared_ptr<source_engine::dmx::Element> &root, size_t maxResults) const { return QueryRunner {m_steps, maxResults}.Run(root); }
@@ -0,0 +1,248 @@
+// SPDX-FileCopyrightText: (c) 2020 Silverlan <opensource@pragma-engine.com>
+// SPDX-License-Identifier: MIT
+
+module pragma.modules.dmx;
+
+import :arrays;
+import :lazy;
+import :sampler;
+
+static source_engine::dmx::Attribute *find_attribute(const std::shared_ptr<source_engine::dmx::Element> &el, const std::string &name)
+{
+	pragma::modules::dmx::materialize(el);
+	auto it = el->attributes.find(name);
+	return (it != el->attributes.end()) ? it->second.get() : nullptr;
+}
+
+static std::shared_ptr<source_engine::dmx::Element> get_element(const source_engine::dmx::Attribute *attr)
+{
+	if(attr == nullptr || attr->type != source_engine::dmx::AttrType::Element || attr->data == nullptr)
+		return nullptr;
+	return static_cast<std::weak_ptr<source_engine::dmx::Element> *>(attr->data.get())->lock();
+}
+
+// Converts packed entries to floats, 'out' must be able to hold layout.componentCount *count floats
+static void to_floats(const uint8_t *data, const pragma::modules::dmx::ArrayLayout &layout, size_t count, float *out)
+{
+	auto n = count * layout.componentCount;
+	switch(layout.componentType) {
+	case pragma::modules::dmx::ComponentType::Float:
+		std::memcpy(out, data, n * sizeof(float));
+		break;
+	case pragma::modules::dmx::ComponentType::Int32:
+		for(size_t i = 0; i < n; ++i) {
+			int32_t v;
+			std::memcpy(&v, data + i * sizeof(int32_t), sizeof(v));
+			out[i] = static_cast<float>(v);
+		}
+		break;
+	case pragma::modules::dmx::ComponentType::UInt8:
+		for(size_t i = 0; i < n; ++i)
+			out[i] = static_cast<float>(data[i]);
+		break;
+	default:
+		std::fill(out, out + n, 0.f);
+		break;
+	}
+}
+
+// Shortest-path spherical interpolation between two w, x, y, z quaternions
+static void slerp(const float *a, const float *b, float f, float *out)
+{
+	auto cosTheta = a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3];
+	auto sign = 1.f;
+	if(cosTheta < 0.f) {
+		cosTheta = -cosTheta;
+		sign = -1.f;
+	}
+	float wa, wb;
+	if(cosTheta > 0.9995f) {
+		// Nearly parallel, sin(theta) would be too close to 0
+		wa = 1.f - f;
+		wb = f;
+	}
+	else {
+		auto theta = std::acos(cosTheta);
+		auto sinTheta = std::sin(theta);
+		wa = std::sin((1.f - f) * theta) / sinTheta;
+		wb = std::sin(f * theta) / sinTheta;
+	}
+	wb *= sign;
+	auto len = 0.f;
+	for(auto c = 0u; c < 4; ++c) {
+		out[c] = a[c] * wa + b[c] * wb;
+		len += out[c] * out[c];
+	}
+	if(len > 0.f) {
+		len = 1.f / std::sqrt(len);
+		for(auto c = 0u; c < 4; ++c)
+			out[c] *= len;
+	}
+}
+
+std::shared_ptr<pragma::modules::dmx::Sampler> pragma::modules::dmx::Sampler::Create(const std::vector<std::shared_ptr<source_engine::dmx::Element>> &sources, std::string &outErr)
+{
+	auto sampler = std::shared_ptr<Sampler> {new Sampler {}};
+	sampler->m_channels.reserve(sources.size());
+	for(auto i = decltype(sources.size()) {0u}; i < sources.size(); ++i) {
+		std::string err;
+		if(!sampler->AddChannel(sources[i], err)) {
+			outErr = "Channel " + std::to_string(i + 1) + ": " + err;
+			return nullptr;
+		}
+	}
+	sampler->m_times.shrink_to_fit();
+	sampler->m_values.shrink_to_fit();
+	sampler->m_cursors.resize(sampler->m_channels.size(), 0);
+	return sampler;
+}
+
+bool pragma::modules::dmx::Sampler::AddChannel(const std::shared_ptr<source_engine::dmx::Element> &source, std::string &outErr)
+{
+	if(source == nullptr) {
+		outErr = "Invalid element";
+		return false;
+	}
+	// Resolve DmeChannel -> DmeLog -> base DmeLogLayer
+	std::shared_ptr<source_engine::dmx::Element> log = nullptr;
+	std::shared_ptr<source_engine::dmx::Element> layer = nullptr;
+	if(find_attribute(source, "times"))
+		layer = source;
+	else {
+		log = find_attribute(source, "layers") ? source : get_element(find_attribute(source, "log"));
+		if(log == nullptr) {
+			outErr = "Element '" + source->name + "' of type '" + source->type + "' is not a channel, log or log layer";
+			return false;
+		}
+		auto *layers = find_attribute(log, "layers");
+		auto *layerValues = layers ? get_array_values(*layers) : nullptr;
+		if(layerValues != nullptr && !layerValues->empty())
+			layer = get_element(layerValues->front().get());
+		if(layer == nullptr) {
+			outErr = "Log '" + log->name + "' has no layers";
+			return false;
+		}
+	}
+
+	auto *times = find_attribute(layer, "times");
+	auto *values = find_attribute(layer, "values");
+	auto *timeValues = times ? get_array_values(*times) : nullptr;
+	auto *keyValues = values ? get_array_values(*values) : nullptr;
+	if(timeValues == nullptr || keyValues == nullptr) {
+		outErr = "Log layer '" + layer->name + "' has no times or values";
+		return false;
+	}
+	auto layout = get_array_layout(values->type);
+	if(!layout.has_value() || layout->componentCount > 4) {
+		outErr = "Unsupported log value type '" + std::string {source_engine::dmx::type_to_string(values->type)} + "'";
+		return false;
+	}
+	if(timeValues->size() != keyValues->size()) {
+		outErr = "Log layer '" + layer->name + "' has " + std::to_string(timeValues->size()) + " times but " + std::to_string(keyValues->size()) + " values";
+		return false;
+	}
+
+	Channel channel {};
+	channel.valueType = get_array_entry_type(values->type);
+	channel.componentCount = layout->componentCount;
+	if(values->type == source_engine::dmx::AttrType::QuaternionArray)
+		channel.interpolation = Interpolation::Slerp;
+	else if(layout->componentType != ComponentType::Float)
+		channel.interpolation = Interpolation::Step;
+	channel.keyOffset = static_cast<uint32_t>(m_times.size());
+	channel.keyCount = static_cast<uint32_t>(timeValues->size());
+	channel.valueOffset = static_cast<uint32_t>(m_values.size());
+	channel.outputOffset = static_cast<uint32_t>(m_outputSize);
+
+	std::vector<uint8_t> packed;
+	if(channel.keyCount > 0) {
+		m_times.resize(m_times.size() + channel.keyCount);
+		pack_array(*timeValues, source_engine::dmx::AttrType::TimeArray, reinterpret_cast<uint8_t *>(m_times.data() + channel.keyOffset));
+
+		packed.resize(keyValues->size() * layout->GetEntrySize());
+		pack_array(*keyValues, values->type, packed.data());
+		m_values.resize(m_values.size() + keyValues->size() * channel.componentCount);
+		to_floats(packed.data(), *layout, keyValues->size(), m_values.data() + channel.valueOffset);
+
+		auto startTime = m_times[channel.keyOffset];
+		auto endTime = m_times[channel.keyOffset + channel.keyCount - 1];
+		auto isFirstKeyedChannel = (m_times.size() == channel.keyCount);
+		if(isFirstKeyedChannel || startTime < m_startTime)
+			m_startTime = startTime;
+		if(isFirstKeyedChannel || endTime > m_endTime)
+			m_endTime = endTime;
+	}
+	else {
+		// Without any keys the log evaluates to its default value
+		m_values.resize(m_values.size() + channel.componentCount, 0.f);
+		auto *defaultValue = log ? find_attribute(log, "defaultvalue") : nullptr;
+		packed.resize(layout->GetEntrySize());
+		if(defaultValue && get_array_type(defaultValue->type) == values->type && pack_value(*defaultValue, packed.data()))
+			to_floats(packed.data(), *layout, 1, m_values.data() + channel.valueOffset);
+		else if(channel.interpolation == Interpolation::Slerp)
+			m_values[channel.valueOffset] = 1.f; // Identity rotation
+	}
+
+	m_channels.push_back(channel);
+	m_outputSize += channel.componentCount;
+	return true;
+}
+
+uint32_t pragma::modules::dmx::Sampler::FindKey(size_t channelIdx, float t)
+{
+	// Returns the index of the key k with times[k] <= t < times[k +1], 't' has to be within the time range of the channel
+	auto &channel = m_channels[channelIdx];
+	auto *times = m_times.data() + channel.keyOffset;
+	auto &cursor = m_cursors[channelIdx];
+	if(cursor + 1 < channel.keyCount && times[cursor] <= t) {
+		if(t < times[cursor + 1])
+			return cursor;
+		// Playback usually only advances by a single key per call
+		if(cursor + 2 < channel.keyCount && t < times[cursor + 2])
+			return ++cursor;
+	}
+	auto it = std::upper_bound(times, times + channel.keyCount, t);
+	auto idx = static_cast<uint32_t>(it - times);
+	cursor = std::clamp<uint32_t>((idx > 0) ? (idx - 1) : 0, 0, channel.keyCount - 2);
+	return cursor;
+}
+
+void pragma::modules::dmx::Sampler::Sample(float t, float *out)
+{
+	for(auto i = decltype(m_channels.size()) {0u}; i < m_channels.size(); ++i) {
+		auto &channel = m_channels[i];
+		auto n = channel.componentCount;
+		auto *dst = out + channel.outputOffset;
+		auto *values = m_values.data() + channel.valueOffset;
+		if(channel.keyCount <= 1) {
+			std::memcpy(dst, values, n * sizeof(float));
+			continue;
+		}
+		auto *times = m_times.data() + channel.keyOffset;
+		if(t <= times[0]) {
+			std::memcpy(dst, values, n * sizeof(float));
+			continue;
+		}
+		if(t >= times[channel.keyCount - 1]) {
+			std::memcpy(dst, values + (channel.keyCount - 1) * n, n * sizeof(float));
+			continue;
+		}
+		auto k = FindKey(i, t);
+		auto *a = values + k * n;
+		auto *b = a + n;
+		if(channel.interpolation == Interpolation::Step) {
+			std::memcpy(dst, a, n * sizeof(float));
+			continue;
+		}
+		auto dt = times[k + 1] - times[k];
+		auto f = (dt > 0.f) ? ((t - times[k]) / dt) : 0.f;
+		if(channel.interpolation == Interpolation::Slerp)
+			slerp(a, b, f, dst);
+		else {
+			for(auto c = 0u; c < n; ++c)
+				dst[c] = a[c] + (b[c] - a[c]) * f;
+		}
+	}
+}
+
+void pragma::modules::dmx::Sampler::Reset() { std::fill(m_cursors.begin(), m_cursors.end(), 0); }
@@ -0,0 +1,96 @@
+// SPDX-FileCopyrightText: (c) 2020 Silverlan <opensource@pragma-engine.com>
+// SPDX-License-Identifier: MIT
+
+module pragma.modules.dmx;
+
+import :arrays;
+import :cache;
+import :stats;
+
+static uint64_t get_payload_size(const source_engine::dmx::Attribute &attr)
+{
+	if(attr.data == nullptr)
+		return 0;
+	switch(attr.type) {
+	case source_engine::dmx::AttrType::String:
+		return static_cast<std::string *>(attr.data.get())->size();
+	case source_engine::dmx::AttrType::Binary:
+		return static_cast<std::vector<uint8_t> *>(attr.data.get())->size();
+	case source_engine::dmx::AttrType::Element:
+		return sizeof(std::weak_ptr<source_engine::dmx::Element>);
+	default:
+		break;
+	}
+	auto layout = pragma::modules::dmx::get_array_layout(pragma::modules::dmx::get_array_type(attr.type));
+	return layout.has_value() ? layout->GetEntrySize() : 0;
+}
+
+pragma::modules::dmx::ContentStats pragma::modules::dmx::ContentStats::Compute(source_engine::dmx::FileData &data)
+{
+	auto t = std::chrono::steady_clock::now();
+	ContentStats stats {};
+	auto &elements = data.GetElements();
+	for(auto &el : elements) {
+		if(el == nullptr)
+			continue;
+		++stats.elementCount;
+		for(auto &pair : el->attributes) {
+			auto &attr = pair.second;
+			if(attr == nullptr)
+				continue;
+			++stats.attributeCount;
+			++stats.attributesByType[attr->type];
+			auto *values = get_array_values(*attr);
+			if(values == nullptr)
+				continue;
+			stats.arrayEntryCount += values->size();
+			for(auto &val : *values) {
+				if(val)
+					stats.arrayPayloadBytes += get_payload_size(*val);
+			}
+		}
+	}
+	stats.estimatedMemory = estimate_memory_usage(data);
+	stats.analyzeTimeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t).count();
+	return stats;
+}
+
+bool pragma::modules::dmx::read_header(ufile::IFile &f, LoadStats &outStats)
+{
+	auto offset = f.Tell();
+	std::array<char, 128> buf {};
+	auto n = f.Read(buf.data(), buf.size() - 1);
+	f.Seek(offset);
+	std::string_view header {buf.data(), n};
+	auto end = header.find("-->");
+	if(header.substr(0, 4) != "<!--" || end == std::string_view::npos)
+		return false;
+	// e.g. "<!-- dmx encoding binary 5 format model 18 -->"
+	std::stringstream ss {std::string {header.substr(4, end - 4)}};
+	std::string token;
+	while(ss >> token) {
+		if(token == "encoding")
+			ss >> outStats.encoding >> outStats.encodingVersion;
+		else if(token == "format")
+			ss >> outStats.format >> outStats.formatVersion;
+	}
+	return !outStats.encoding.empty();
+}
+
+static std::atomic<bool> g_profilingEnabled = false;
+static std::array<std::atomic<uint64_t>, pragma::math::to_integral(pragma::modules::dmx::Counter::Count)> g_counters {};
+
+void pragma::modules::dmx::set_profiling_enabled(bool enabled) { g_profilingEnabled.store(enabled, std::memory_order_relaxed); }
+bool pragma::modules::dmx::is_profiling_enabled() { return g_profilingEnabled.load(std::memory_order_relaxed); }
+void pragma::modules::dmx::increment_counter(Counter counter, uint64_t n)
+{
+	if(!is_profiling_enabled())
+		return;
+	g_counters[pragma::math::to_integral(counter)].fetch_add(n, std::memory_order_relaxed);
+}
+uint64_t pragma::modules::dmx::get_counter(Counter counter) { return g_counters[pragma::math::to_integral(counter)].load(std::memory_order_relaxed); }
+void pragma::modules::dmx::reset_counters()
+{
+	for(auto &counter : g_counters)
+		counter.store(0, std::memory_order_relaxed);
+}
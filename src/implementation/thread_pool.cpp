@@ -0,0 +1,121 @@
+// SPDX-FileCopyrightText: (c) 2020 Silverlan <opensource@pragma-engine.com>
+// SPDX-License-Identifier: MIT
+
+module pragma.modules.dmx;
+
+import :thread_pool;
+
+uint32_t pragma::modules::dmx::get_default_thread_count() { return std::max(std::thread::hardware_concurrency(), 1u); }
+
+pragma::modules::dmx::ThreadPool &pragma::modules::dmx::ThreadPool::Get()
+{
+	static ThreadPool pool {get_default_thread_count()};
+	return pool;
+}
+
+pragma::modules::dmx::ThreadPool::ThreadPool(uint32_t threadCount)
+{
+	m_threads.reserve(threadCount);
+	for(auto i = 0u; i < threadCount; ++i)
+		m_threads.emplace_back(&ThreadPool::Run, this);
+}
+
+pragma::modules::dmx::ThreadPool::~ThreadPool()
+{
+	{
+		std::scoped_lock lock {m_mutex};
+		m_stop = true;
+	}
+	m_condition.notify_all();
+	for(auto &t : m_threads)
+		t.join();
+}
+
+void pragma::modules::dmx::ThreadPool::Enqueue(std::function<void()> task)
+{
+	{
+		std::scoped_lock lock {m_mutex};
+		m_tasks.push_back(std::move(task));
+	}
+	m_condition.notify_one();
+}
+
+void pragma::modules::dmx::ThreadPool::Run()
+{
+	for(;;) {
+		std::function<void()> task;
+		{
+			std::unique_lock lock {m_mutex};
+			m_condition.wait(lock, [this]() { return m_stop || !m_tasks.empty(); });
+			if(m_tasks.empty())
+				return;
+			task = std::move(m_tasks.front());
+			m_tasks.pop_front();
+		}
+		try {
+			task();
+		}
+		catch(...) {
+		}
+	}
+}
+
+void pragma::modules::dmx::parallel_for(size_t count, uint32_t threadCount, const std::function<void(size_t)> &fn)
+{
+	if(count == 0)
+		return;
+	auto &pool = ThreadPool::Get();
+	threadCount = static_cast<uint32_t>(std::clamp<size_t>(threadCount, 1, std::min<size_t>(count, pool.GetThreadCount() + 1)));
+
+	// Helpers may only be picked up by a worker after the caller has already returned, so everything they
+	// touch is kept alive by the shared state, and 'fn' is only used while the caller is still waiting.
+	struct State {
+		std::atomic<size_t> next {0};
+		std::atomic<bool> failed {false};
+		std::exception_ptr exception = nullptr;
+		std::mutex mutex;
+		std::condition_variable condition;
+		uint32_t running = 0;
+		bool done = false;
+	};
+	auto state = std::make_shared<State>();
+	auto work = [count, &fn](State &state) {
+		for(;;) {
+			auto i = state.next.fetch_add(1, std::memory_order_relaxed);
+			if(i >= count || state.failed.load(std::memory_order_relaxed))
+				break;
+			try {
+				fn(i);
+			}
+			catch(...) {
+				std::scoped_lock lock {state.mutex};
+				if(state.exception == nullptr)
+					state.exception = std::current_exception();
+				state.failed = true;
+			}
+		}
+	};
+	for(auto i = 1u; i < threadCount; ++i) {
+		pool.Enqueue([state, work]() {
+			{
+				std::scoped_lock lock {state->mutex};
+				if(state->done)
+					return;
+				++state->running;
+			}
+			work(*state);
+			{
+				std::scoped_lock lock {state->mutex};
+				--state->running;
+			}
+			state->condition.notify_all();
+		});
+	}
+	work(*state);
+
+	std::unique_lock lock {state->mutex};
+	state->done = true;
+	state->condition.wait(lock, [&state]() { return state->running == 0; });
+	if(state->exception)
+		std::rethrow_exception(state->exception);
+}
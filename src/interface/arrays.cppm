@@ -0,0 +1,43 @@
+// SPDX-FileCopyrightText: (c) 2020 Silverlan <opensource@pragma-engine.com>
+// SPDX-License-Identifier: MIT
+
+export module pragma.modules.dmx:arrays;
+
+export import pragma.shared;
+export import source_engine.dmx;
+
+export namespace pragma::modules::dmx {
+	enum class ComponentType : uint8_t {
+		None = 0,
+		Float,
+		Int32,
+		UInt8,
+	};
+
+	// Memory layout of a single array entry once packed, e.g. Vector3Array -> 3x Float
+	struct ArrayLayout {
+		ComponentType componentType = ComponentType::None;
+		uint32_t componentCount = 0;
+		size_t GetComponentSize() const;
+		size_t GetEntrySize() const { return GetComponentSize() * componentCount; }
+	};
+
+	bool is_array_type(source_engine::dmx::AttrType type);
+	// Returns the type of a single entry of an array type, e.g. Vector3Array -> Vector3
+	source_engine::dmx::AttrType get_array_entry_type(source_engine::dmx::AttrType arrayType);
+	// Inverse of get_array_entry_type, e.g. Vector3 -> Vector3Array
+	source_engine::dmx::AttrType get_array_type(source_engine::dmx::AttrType entryType);
+	// Returns std::nullopt for array types without a fixed-size numeric representation (Element, String, Binary, ...)
+	std::optional<ArrayLayout> get_array_layout(source_engine::dmx::AttrType arrayType);
+	const std::vector<std::shared_ptr<source_engine::dmx::Attribute>> *get_array_values(const source_engine::dmx::Attribute &attr);
+
+	// Writes the values of a numeric array attribute tightly packed at the current offset of the stream.
+	// Quaternions are written as w, x, y, z, angles as pitch, yaw, roll and matrices in column-major order.
+	// Returns the number of array entries written, or std::nullopt if the attribute is not a packable array.
+	std::optional<size_t> pack_array(const source_engine::dmx::Attribute &attr, pragma::util::DataStream &ds);
+	// Writes a single non-array value with the same layout as an entry of the corresponding array type.
+	// 'outData' must be able to hold get_array_layout(get_array_type(attr.type))->GetEntrySize() bytes.
+	bool pack_value(const source_engine::dmx::Attribute &attr, uint8_t *outData);
+	// Packs the values into the specified buffer, which must be able to hold GetEntrySize() *numValues bytes
+	void pack_array(const std::vector<std::shared_ptr<source_engine::dmx::Attribute>> &values, source_engine::dmx::AttrType arrayType, uint8_t *outData);
+};
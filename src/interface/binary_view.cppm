@@ -0,0 +1,37 @@
+// SPDX-FileCopyrightText: (c) 2020 Silverlan <opensource@pragma-engine.com>
+// SPDX-License-Identifier: MIT
+
+export module pragma.modules.dmx:binary_view;
+
+export import pragma.shared;
+export import source_engine.dmx;
+
+export namespace pragma::modules::dmx {
+	// Read-only window into the payload of a Binary attribute. The view shares ownership of the payload,
+	// so it stays valid even if the attribute or the FileData are released.
+	class BinaryView {
+	  public:
+		static std::optional<BinaryView> Create(const source_engine::dmx::Attribute &attr);
+		BinaryView(const std::shared_ptr<const std::vector<uint8_t>> &data, size_t offset, size_t size);
+
+		const uint8_t *GetData() const { return m_data->data() + m_offset; }
+		size_t GetSize() const { return m_size; }
+		std::optional<BinaryView> Slice(size_t offset, size_t size) const;
+		template<typename T>
+		    requires(std::is_trivially_copyable_v<T>)
+		std::optional<T> Read(size_t offset) const
+		{
+			if(offset > m_size || m_size - offset < sizeof(T))
+				return {};
+			T value;
+			std::memcpy(&value, GetData() + offset, sizeof(T));
+			return value;
+		}
+		// Explicit copy of the viewed bytes
+		pragma::util::DataStream ToDataStream() const;
+	  private:
+		std::shared_ptr<const std::vector<uint8_t>> m_data;
+		size_t m_offset = 0;
+		size_t m_size = 0;
+	};
+};
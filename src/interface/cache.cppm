@@ -0,0 +1,62 @@
+// SPDX-FileCopyrightText: (c) 2020 Silverlan <opensource@pragma-engine.com>
+// SPDX-License-Identifier: MIT
+
+export module pragma.modules.dmx:cache;
+
+export import :loader;
+
+export namespace pragma::modules::dmx {
+	size_t estimate_memory_usage(const source_engine::dmx::Attribute &attr);
+	size_t estimate_memory_usage(const source_engine::dmx::Element &el);
+	size_t estimate_memory_usage(const source_engine::dmx::FileData &data);
+
+	// Process-wide cache of parsed files, keyed by the normalized absolute path. Disabled until a budget is set.
+	// Entries are invalidated if the modification time or size of the file has changed.
+	// Cached FileData objects are shared between all callers and are not copied on write: modifying one
+	// (e.g. through Attribute:AddArrayValue/RemoveArrayValue or Data:Reload) affects every caller that loaded the same file.
+	// The memory usage of an entry is measured from the parsed element graph (see estimate_memory_usage) when it is added.
+	class FileCache {
+	  public:
+		static constexpr size_t DEFAULT_BUDGET = 0;
+		struct Stats {
+			size_t entryCount = 0;
+			size_t memoryUsage = 0;
+			size_t budget = 0;
+			uint64_t hits = 0;
+			uint64_t misses = 0;
+			uint64_t evictions = 0;
+		};
+		using Loader = std::function<LoadResult(const std::string &)>;
+
+		static FileCache &Get();
+		LoadResult Load(const std::string &path, const Loader &loader);
+		void Invalidate(const std::string &path);
+		// Removes the entry that holds 'data', if there is one. Holders of 'data' keep it, but later loads parse the file again.
+		void Detach(const source_engine::dmx::FileData &data);
+		void Clear();
+		// A budget of 0 disables the cache
+		void SetBudget(size_t budget);
+		Stats GetStats() const;
+	  private:
+		struct Entry {
+			std::string key;
+			std::filesystem::file_time_type modificationTime;
+			uintmax_t fileSize = 0;
+			std::shared_ptr<source_engine::dmx::FileData> data;
+			size_t memoryUsage = 0;
+		};
+		FileCache() = default;
+		static std::optional<std::string> GetKey(const std::string &path);
+		void Evict();
+		void Erase(std::list<Entry>::iterator it);
+
+		mutable std::mutex m_mutex;
+		std::list<Entry> m_entries; // Most recently used first
+		std::unordered_map<std::string, std::list<Entry>::iterator> m_lookup;
+		size_t m_memoryUsage = 0;
+		size_t m_budget = DEFAULT_BUDGET;
+		uint64_t m_hits = 0;
+		uint64_t m_misses = 0;
+		uint64_t m_evictions = 0;
+	};
+};
@@ -0,0 +1,67 @@
+// SPDX-FileCopyrightText: (c) 2020 Silverlan <opensource@pragma-engine.com>
+// SPDX-License-Identifier: MIT
+
+export module pragma.modules.dmx:data_info;
+
+export import pragma.shared;
+export import source_engine.dmx;
+export import :stats;
+
+export namespace pragma::modules::dmx {
+	class DataInfo;
+	// Hash indices over the elements of a FileData
+	class ElementIndex {
+	  public:
+		static std::unique_ptr<ElementIndex> Build(source_engine::dmx::FileData &data);
+		std::shared_ptr<source_engine::dmx::Element> FindByGUID(const std::string &guid) const;
+		const std::vector<std::weak_ptr<source_engine::dmx::Element>> *FindByType(const std::string &type) const;
+		const std::vector<std::weak_ptr<source_engine::dmx::Element>> *FindByName(const std::string &name) const;
+	  private:
+		friend DataInfo;
+		ElementIndex() = default;
+		std::unordered_map<std::string, std::weak_ptr<source_engine::dmx::Element>> m_byGuid;
+		std::unordered_map<std::string, std::vector<std::weak_ptr<source_engine::dmx::Element>>> m_byType;
+		std::unordered_map<std::string, std::vector<std::weak_ptr<source_engine::dmx::Element>>> m_byName;
+	};
+
+	// Module-side state attached to a loaded FileData, which cannot hold it itself
+	class DataInfo {
+	  public:
+		DataInfo(const std::shared_ptr<source_engine::dmx::FileData> &data);
+		std::shared_ptr<source_engine::dmx::FileData> GetData() const { return m_data.lock(); }
+		// Builds the index on first use
+		const ElementIndex &GetIndex();
+		// Computes the content statistics on first use
+		ContentStats GetContentStats();
+		// Discards the index and content statistics, e.g. after the element graph has changed
+		void InvalidateCaches();
+
+		void SetLoadStats(const LoadStats &stats);
+		std::optional<LoadStats> GetLoadStats() const;
+
+		// Path the data was loaded from, empty if it was loaded from a file handle
+		void SetSourcePath(const std::string &path);
+		std::string GetSourcePath() const;
+	  private:
+		std::weak_ptr<source_engine::dmx::FileData> m_data;
+		mutable std::mutex m_mutex;
+		std::unique_ptr<ElementIndex> m_index;
+		std::optional<ContentStats> m_contentStats {};
+		std::optional<LoadStats> m_loadStats {};
+		std::string m_sourcePath;
+	};
+
+	// Maps loaded FileData objects to their DataInfo. Entries are removed once the FileData has been destroyed.
+	class DataRegistry {
+	  public:
+		static DataRegistry &Get();
+		std::shared_ptr<DataInfo> Register(const std::shared_ptr<source_engine::dmx::FileData> &data);
+		// Returns nullptr if the FileData was not loaded through this module
+		std::shared_ptr<DataInfo> Find(const source_engine::dmx::FileData &data);
+	  private:
+		DataRegistry() = default;
+		void Prune();
+		std::mutex m_mutex;
+		std::unordered_map<const source_engine::dmx::FileData *, std::shared_ptr<DataInfo>> m_infos;
+	};
+};
@@ -0,0 +1,59 @@
+// SPDX-FileCopyrightText: (c) 2020 Silverlan <opensource@pragma-engine.com>
+// SPDX-License-Identifier: MIT
+
+export module pragma.modules.dmx:diff;
+
+export import pragma.shared;
+export import source_engine.dmx;
+
+export namespace pragma::modules::dmx {
+	// Range of array entries that differ. Ranges are 0-based and may extend past the end of the shorter array.
+	struct ArrayRange {
+		uint32_t start = 0;
+		uint32_t count = 0;
+	};
+
+	struct AttributeChange {
+		enum class Kind : uint8_t {
+			Added = 0,
+			Removed,
+			Changed,
+		};
+		std::string name;
+		Kind kind = Kind::Changed;
+		source_engine::dmx::AttrType oldType = source_engine::dmx::AttrType::Invalid;
+		source_engine::dmx::AttrType newType = source_engine::dmx::AttrType::Invalid;
+		// Only set for changed arrays whose type has not changed
+		std::vector<ArrayRange> ranges;
+		uint32_t oldCount = 0;
+		uint32_t newCount = 0;
+	};
+
+	struct ElementChange {
+		std::string guid;
+		std::shared_ptr<source_engine::dmx::Element> oldElement;
+		std::shared_ptr<source_engine::dmx::Element> newElement;
+		bool nameChanged = false;
+		bool typeChanged = false;
+		std::vector<AttributeChange> attributes; // Sorted by name
+	};
+
+	// Elements are matched by GUID. Element references are compared by the GUID of the referenced element.
+	struct Diff {
+		std::vector<std::shared_ptr<source_engine::dmx::Element>> added;   // Elements of the new data
+		std::vector<std::shared_ptr<source_engine::dmx::Element>> removed; // Elements of the old data
+		std::vector<ElementChange> changed;
+		bool IsEmpty() const { return added.empty() && removed.empty() && changed.empty(); }
+	};
+
+	Diff diff(source_engine::dmx::FileData &oldData, source_engine::dmx::FileData &newData);
+
+	// Re-parses the file the data was loaded from and replaces the contents of 'data' with the reloaded elements.
+	// Elements of the previous data that are matched by GUID are updated to the reloaded values, so existing handles
+	// to them stay valid. Their attributes share the payloads of the reloaded attributes, but they are no longer part
+	// of 'data' themselves; ElementChange::newElement is the element that replaced them.
+	// The returned diff is the same as the one of 'diff' between the previous and the reloaded data.
+	// Every holder of 'data' sees the changes, including callers that received the same FileData from the FileCache.
+	// The data is removed from the cache, so later loads of the file return a new FileData.
+	std::optional<Diff> reload(source_engine::dmx::FileData &data, std::string &outErr);
+};
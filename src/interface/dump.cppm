@@ -0,0 +1,38 @@
+// SPDX-FileCopyrightText: (c) 2020 Silverlan <opensource@pragma-engine.com>
+// SPDX-License-Identifier: MIT
+
+export module pragma.modules.dmx:dump;
+
+export import pragma.shared;
+export import source_engine.dmx;
+
+export namespace pragma::modules::dmx {
+	struct DumpOptions {
+		enum class Format : uint8_t {
+			Text = 0,
+			Json,
+		};
+		Format format = Format::Text;
+		// Elements deeper than this are written as references only
+		uint32_t maxDepth = 16;
+		// Maximum number of elements whose attributes are written
+		uint64_t maxElements = 10'000;
+		// The dump stops at the next attribute or array entry once this many bytes have been written. JSON output is still closed properly.
+		uint64_t maxBytes = 1'024 * 1'024;
+		// Number of entries written for arrays of values, the remaining entries are only counted
+		uint32_t maxArrayEntries = 16;
+	};
+
+	struct DumpResult {
+		uint64_t elementCount = 0;
+		uint64_t bytesWritten = 0;
+		bool truncated = false;
+	};
+
+	// Receives the output in chunks
+	using DumpSink = std::function<void(std::string_view)>;
+
+	// Writes the element and everything it references without recursion. Elements that have already been written are referenced by name and GUID.
+	DumpResult dump(const std::shared_ptr<source_engine::dmx::Element> &root, const DumpOptions &options, const DumpSink &sink);
+	DumpResult dump(source_engine::dmx::Attribute &attr, const DumpOptions &options, const DumpSink &sink);
+};
@@ -0,0 +1,97 @@
+// SPDX-FileCopyrightText: (c) 2020 Silverlan <opensource@pragma-engine.com>
+// SPDX-License-Identifier: MIT
+
+export module pragma.modules.dmx:frozen;
+
+export import pragma.shared;
+export import source_engine.dmx;
+
+export namespace pragma::modules::dmx {
+	// Compact read-only copy of a FileData. Elements and attributes are stored in flat arrays and
+	// address each other by index, names are interned and array payloads are stored in typed contiguous
+	// buffers (using the same packed layout as pack_array).
+	class FrozenDocument {
+	  public:
+		using Index = uint32_t;
+		using StringId = uint32_t;
+		static constexpr Index INVALID_INDEX = std::numeric_limits<Index>::max();
+
+		struct ElementRecord {
+			StringId name;
+			StringId type;
+			StringId guid;
+			Index firstAttribute; // Attributes of an element are contiguous and sorted by name id
+			uint32_t attributeCount;
+		};
+		// Meaning of 'payload' depends on the type:
+		// Element: element index; String: string id; Binary: index into the binary ranges;
+		// Int, Float, Bool, ... : offset into the typed buffer for the type;
+		// Arrays: offset of the first entry in the typed buffer, with 'count' entries
+		struct AttributeRecord {
+			StringId name;
+			source_engine::dmx::AttrType type;
+			uint32_t payload;
+			uint32_t count;
+		};
+		struct BinaryRange {
+			uint64_t offset;
+			uint64_t size;
+		};
+
+		static std::shared_ptr<FrozenDocument> Create(source_engine::dmx::FileData &data);
+
+		const std::string &GetString(StringId id) const { return *m_strings[id]; }
+		std::optional<StringId> FindString(const std::string &str) const;
+
+		uint32_t GetElementCount() const { return static_cast<uint32_t>(m_elements.size()); }
+		const ElementRecord &GetElement(Index idx) const { return m_elements[idx]; }
+		const AttributeRecord &GetAttribute(Index idx) const { return m_attributes[idx]; }
+		Index GetRootAttribute() const { return m_rootAttribute; }
+		Index FindAttribute(Index elementIdx, const std::string &name) const;
+		// Returns the element index referenced by an Element attribute or INVALID_INDEX
+		Index GetReferencedElement(Index attrIdx) const;
+
+		const float *GetFloats(uint32_t offset) const { return m_floats.data() + offset; }
+		const int32_t *GetInts(uint32_t offset) const { return m_ints.data() + offset; }
+		const uint8_t *GetBytes(uint32_t offset) const { return m_bytes.data() + offset; }
+		const Index *GetElementRefs(uint32_t offset) const { return m_elementRefs.data() + offset; }
+		const StringId *GetStringRefs(uint32_t offset) const { return m_stringRefs.data() + offset; }
+		const BinaryRange &GetBinaryRange(uint32_t idx) const { return m_binaryRanges[idx]; }
+		const std::vector<uint8_t> &GetBinaryBuffer() const { return m_binaryData; }
+
+		size_t GetMemoryUsage() const;
+	  private:
+		FrozenDocument() = default;
+		StringId Intern(const std::string &str);
+
+		std::unordered_map<std::string, StringId> m_stringIds;
+		std::vector<const std::string *> m_strings; // Points into the keys of m_stringIds
+		std::vector<ElementRecord> m_elements;
+		std::vector<AttributeRecord> m_attributes;
+		Index m_rootAttribute = INVALID_INDEX;
+
+		std::vector<float> m_floats;
+		std::vector<int32_t> m_ints;
+		std::vector<uint8_t> m_bytes;
+		std::vector<Index> m_elementRefs;
+		std::vector<StringId> m_stringRefs;
+		std::vector<BinaryRange> m_binaryRanges;
+		std::vector<uint8_t> m_binaryData;
+	};
+
+	// Lua-facing handles into a FrozenDocument
+	struct FrozenElement {
+		std::shared_ptr<const FrozenDocument> document;
+		FrozenDocument::Index index;
+	};
+	struct FrozenAttribute {
+		std::shared_ptr<const FrozenDocument> document;
+		FrozenDocument::Index index;
+		// Entry of an array attribute, or -1 for the attribute itself
+		int32_t arrayIndex = -1;
+		// Type of the value this handle refers to, i.e. the single type for array entries
+		source_engine::dmx::AttrType GetType() const;
+		// Offset of the value in the buffer for its type (see FrozenDocument::AttributeRecord), taking the array entry into account
+		uint32_t GetPayload() const;
+	};
+};
@@ -0,0 +1,62 @@
+// SPDX-FileCopyrightText: (c) 2020 Silverlan <opensource@pragma-engine.com>
+// SPDX-License-Identifier: MIT
+
+export module pragma.modules.dmx:lazy;
+
+export import pragma.shared;
+export import source_engine.dmx;
+export import :mapped_file;
+export import :stats;
+
+export namespace pragma::modules::dmx {
+	// Binary DMX file (encoding version 5) whose element graph is built on demand from a memory mapping.
+	// Opening the file reads the header, the string table and the element table, and validates the attribute data once
+	// to record where the attributes of each element start. Elements are created as empty shells (name, type and GUID)
+	// when they are first referenced, and their attributes are decoded when they are first accessed (see materialize).
+	class LazyDocument : public std::enable_shared_from_this<LazyDocument> {
+	  public:
+		static std::shared_ptr<LazyDocument> Open(const std::string &path, std::string &outErr);
+		LazyDocument(const LazyDocument &) = delete;
+		LazyDocument &operator=(const LazyDocument &) = delete;
+
+		uint32_t GetElementCount() const { return static_cast<uint32_t>(m_elementRecords.size()); }
+		// Number of elements whose attributes have been decoded so far
+		uint32_t GetDecodedElementCount() const { return m_decodedCount.load(std::memory_order_relaxed); }
+		// Returns the element at the specified index in the file, or nullptr if the index is out of range
+		std::shared_ptr<source_engine::dmx::Element> GetElement(uint32_t idx);
+		// Element attribute referring to the first element of the file, or nullptr if the file has no elements
+		const std::shared_ptr<source_engine::dmx::Attribute> &GetRootAttribute() const { return m_rootAttribute; }
+		const LoadStats &GetLoadStats() const { return m_loadStats; }
+		size_t GetFileSize() const { return m_file->GetSize(); }
+
+		// Only called by materialize. Sets 'decoded' once the attributes of the element are complete.
+		void DecodeAttributes(uint32_t idx, source_engine::dmx::Element &el, std::atomic<bool> &decoded);
+	  private:
+		struct ElementRecord {
+			uint32_t type;
+			uint32_t name;
+			std::array<uint8_t, 16> guid;
+		};
+		class Reader;
+		LazyDocument() = default;
+		std::shared_ptr<source_engine::dmx::Element> GetShell(uint32_t idx);
+		bool ReadAttributes(Reader &reader, source_engine::dmx::Element *outEl);
+		bool ReadValue(Reader &reader, uint8_t type, bool inArray, source_engine::dmx::Attribute *outAttr);
+		bool ReadArray(Reader &reader, uint8_t entryType, source_engine::dmx::Attribute *outAttr);
+
+		std::unique_ptr<MappedFile> m_file;
+		std::vector<std::string_view> m_strings; // Point into the mapping
+		std::vector<ElementRecord> m_elementRecords;
+		std::vector<uint64_t> m_attributeOffsets; // Start of the attribute block of each element
+		std::mutex m_mutex; // Guards m_elements and decoding
+		std::vector<std::shared_ptr<source_engine::dmx::Element>> m_elements; // nullptr until referenced
+		std::atomic<uint32_t> m_decodedCount = 0;
+		std::shared_ptr<source_engine::dmx::Attribute> m_rootAttribute;
+		LoadStats m_loadStats;
+	};
+
+	// Decodes the attributes of 'el' if it is an element of a LazyDocument that has not been decoded yet, otherwise
+	// does nothing. Has to be called before the attributes of an element are read. Elements that do not belong to a
+	// LazyDocument, or that have already been decoded, are recognized without taking a lock.
+	void materialize(const std::shared_ptr<source_engine::dmx::Element> &el);
+};
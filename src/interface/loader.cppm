@@ -0,0 +1,44 @@
+// SPDX-FileCopyrightText: (c) 2020 Silverlan <opensource@pragma-engine.com>
+// SPDX-License-Identifier: MIT
+
+export module pragma.modules.dmx:loader;
+
+export import pragma.shared;
+export import source_engine.dmx;
+
+export namespace pragma::modules::dmx {
+	struct LoadResult {
+		std::shared_ptr<source_engine::dmx::FileData> data = nullptr;
+		std::string errorMessage;
+		bool IsSuccessful() const { return data != nullptr; }
+	};
+
+	std::shared_ptr<ufile::IFile> open_file(const std::string &path, std::string &outErr);
+	LoadResult load(const std::shared_ptr<ufile::IFile> &f);
+	// Parses the file from a read-only memory mapping if it is located on disk, otherwise through the file system
+	LoadResult load(const std::string &path);
+
+	// Runs a load on a worker of the ThreadPool. The result is only handed out through Wait/GetResult,
+	// so the caller decides which thread the FileData is consumed on.
+	class LoadJob {
+	  public:
+		static std::shared_ptr<LoadJob> Start(std::function<LoadResult()> task);
+		LoadJob(const LoadJob &) = delete;
+		LoadJob &operator=(const LoadJob &) = delete;
+		// Does not wait for the task. It keeps the result state alive by itself and the result is discarded once it completes.
+		~LoadJob() = default;
+
+		bool IsComplete() const;
+		const LoadResult &Wait();
+		// Returns nullptr if the job has not completed yet
+		const LoadResult *GetResult();
+	  private:
+		struct State {
+			mutable std::mutex mutex;
+			std::condition_variable condition;
+			std::optional<LoadResult> result {};
+		};
+		LoadJob() = default;
+		std::shared_ptr<State> m_state;
+	};
+};
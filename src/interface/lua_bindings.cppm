@@ -4,9 +4,25 @@
 export module pragma.modules.dmx;
 
 export import pragma.lua;
+export import :loader;
+export import :arrays;
+export import :mapped_file;
+export import :cache;
+export import :query;
+export import :data_info;
+export import :binary_view;
+export import :frozen;
+export import :thread_pool;
+export import :stats;
+export import :sampler;
+export import :mesh;
+export import :dump;
+export import :diff;
+export import :lazy;
 
 export namespace Lua {
 	namespace dmx {
 		void register_lua_library(Lua::Interface &l);
+		void unregister_lua_library(Lua::Interface &l);
 	};
 };
@@ -0,0 +1,28 @@
+// SPDX-FileCopyrightText: (c) 2020 Silverlan <opensource@pragma-engine.com>
+// SPDX-License-Identifier: MIT
+
+export module pragma.modules.dmx:mapped_file;
+
+export import pragma.shared;
+
+export namespace pragma::modules::dmx {
+	// Read-only memory mapping of a file on disk
+	class MappedFile {
+	  public:
+		static std::unique_ptr<MappedFile> Open(const std::string &absPath, std::string &outErr);
+		MappedFile(const MappedFile &) = delete;
+		MappedFile &operator=(const MappedFile &) = delete;
+		~MappedFile();
+
+		const uint8_t *GetData() const { return m_data; }
+		size_t GetSize() const { return m_size; }
+	  private:
+		MappedFile() = default;
+		const uint8_t *m_data = nullptr;
+		size_t m_size = 0;
+#ifdef _WIN32
+		void *m_fileHandle = nullptr;
+		void *m_mappingHandle = nullptr;
+#endif
+	};
+};
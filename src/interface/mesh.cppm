@@ -0,0 +1,54 @@
+// SPDX-FileCopyrightText: (c) 2020 Silverlan <opensource@pragma-engine.com>
+// SPDX-License-Identifier: MIT
+
+export module pragma.modules.dmx:mesh;
+
+export import pragma.shared;
+export import source_engine.dmx;
+
+export namespace pragma::modules::dmx {
+	struct MeshLayout {
+		// Names of the DmeVertexData streams to interleave, e.g. {"positions", "normals", "textureCoordinates"}.
+		// If empty, all float streams listed in the "vertexFormat" of the mesh are used.
+		std::vector<std::string> streams;
+		// Merge face-vertices that refer to the same entries in all streams into a single vertex
+		bool weld = true;
+		bool boneWeights = true;
+		uint32_t threadCount = 0; // 0 = get_default_thread_count()
+	};
+
+	struct MeshStream {
+		std::string name;
+		source_engine::dmx::AttrType type = source_engine::dmx::AttrType::Invalid;
+		uint32_t offset = 0; // Offset in bytes within a vertex
+		uint32_t componentCount = 0;
+	};
+
+	struct MeshFaceSet {
+		std::shared_ptr<source_engine::dmx::Element> material;
+		uint32_t firstIndex = 0;
+		uint32_t indexCount = 0;
+	};
+
+	// The buffers are written into DataStreams directly, so they can be handed to Lua without another copy
+	struct ExtractedMesh {
+		static constexpr uint32_t MAX_JOINT_COUNT = 64;
+		std::shared_ptr<source_engine::dmx::Element> mesh;
+		std::vector<MeshStream> streams;
+		uint32_t vertexStride = 0; // In bytes
+		uint32_t vertexCount = 0;
+		pragma::util::DataStream vertices; // Interleaved floats, vertexCount *vertexStride bytes
+		uint32_t indexCount = 0;
+		pragma::util::DataStream indices; // uint32 triangle list, polygons are triangulated as fans
+		std::vector<MeshFaceSet> faceSets;
+		// Per vertex: jointCount x {int32 joint index, float weight}
+		uint32_t jointCount = 0;
+		pragma::util::DataStream boneWeights;
+	};
+
+	// Returns all DmeMesh elements that can be reached from 'root', including 'root' itself
+	std::vector<std::shared_ptr<source_engine::dmx::Element>> find_meshes(const std::shared_ptr<source_engine::dmx::Element> &root);
+	// Extracts the meshes in parallel. On failure (including failed allocations), the error of the first mesh that could not be extracted is returned in 'outErr'.
+	std::optional<std::vector<ExtractedMesh>> extract_meshes(const std::vector<std::shared_ptr<source_engine::dmx::Element>> &meshes, const MeshLayout &layout, std::string &outErr);
+	bool extract_mesh(const std::shared_ptr<source_engine::dmx::Element> &mesh, const MeshLayout &layout, ExtractedMesh &outMesh, std::string &outErr);
+};
@@ -0,0 +1,39 @@
+// SPDX-FileCopyrightText: (c) 2020 Silverlan <opensource@pragma-engine.com>
+// SPDX-License-Identifier: MIT
+
+export module pragma.modules.dmx:query;
+
+export import pragma.shared;
+export import source_engine.dmx;
+
+export namespace pragma::modules::dmx {
+	// Pre-parsed path query, e.g. "animationList/*/channels/*[type=DmeChannel]/log".
+	// Each step selects attributes of an element by name, or entries of an array attribute by 1-based index.
+	// "*" selects all attributes / array entries. Element and ElementArray attributes are dereferenced automatically.
+	// Predicates ([type=...], [name=...]) only match elements.
+	class Query {
+	  public:
+		struct Predicate {
+			enum class Kind : uint8_t { Type = 0, Name };
+			Kind kind;
+			std::string value;
+		};
+		struct Step {
+			std::string name;
+			bool wildcard = false;
+			std::optional<uint32_t> index {}; // 0-based
+			std::vector<Predicate> predicates;
+		};
+		using Match = std::variant<std::shared_ptr<source_engine::dmx::Element>, std::shared_ptr<source_engine::dmx::Attribute>>;
+
+		static std::shared_ptr<Query> Compile(const std::string &query, std::string &outErr);
+		// Stops walking the graph as soon as 'maxResults' matches have been found
+		std::vector<Match> Run(const std::shared_ptr<source_engine::dmx::Element> &root, size_t maxResults = std::numeric_limits<size_t>::max()) const;
+		const std::string &GetSource() const { return m_source; }
+		const std::vector<Step> &GetSteps() const { return m_steps; }
+	  private:
+		Query() = default;
+		std::string m_source;
+		std::vector<Step> m_steps;
+	};
+};
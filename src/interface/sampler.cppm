@@ -0,0 +1,58 @@
+// SPDX-FileCopyrightText: (c) 2020 Silverlan <opensource@pragma-engine.com>
+// SPDX-License-Identifier: MIT
+
+export module pragma.modules.dmx:sampler;
+
+export import pragma.shared;
+export import source_engine.dmx;
+
+export namespace pragma::modules::dmx {
+	// Evaluates a fixed set of animation log layers (DmeChannel / DmeLog / DmeLogLayer) at arbitrary times.
+	// The key times and values of all channels are copied into contiguous buffers once, so sampling does not touch the element graph.
+	// Every channel writes its value to a fixed offset of the output buffer, with the same component layout as pack_array
+	// (quaternions as w, x, y, z). Bool, Int and Color logs are stepped, Quaternion logs use slerp and all other logs are interpolated linearly.
+	class Sampler {
+	  public:
+		enum class Interpolation : uint8_t {
+			Step = 0,
+			Linear,
+			Slerp,
+		};
+		struct Channel {
+			source_engine::dmx::AttrType valueType = source_engine::dmx::AttrType::Invalid;
+			Interpolation interpolation = Interpolation::Linear;
+			uint32_t componentCount = 0;
+			uint32_t keyOffset = 0;   // Index of the first key in the time buffer
+			uint32_t keyCount = 0;    // If 0, the channel always evaluates to its default value
+			uint32_t valueOffset = 0; // Index of the first component in the value buffer
+			uint32_t outputOffset = 0;
+		};
+
+		// 'sources' may be DmeChannel, DmeLog or DmeLogLayer elements. Channels and logs are resolved to their first (base) layer.
+		static std::shared_ptr<Sampler> Create(const std::vector<std::shared_ptr<source_engine::dmx::Element>> &sources, std::string &outErr);
+
+		size_t GetChannelCount() const { return m_channels.size(); }
+		const Channel &GetChannel(size_t idx) const { return m_channels[idx]; }
+		// Number of floats written by Sample
+		size_t GetOutputSize() const { return m_outputSize; }
+		std::pair<float, float> GetTimeRange() const { return {m_startTime, m_endTime}; }
+
+		// Writes GetOutputSize() floats to 'out'. The key search resumes from the key found by the previous call,
+		// so regular playback does not need a binary search per channel.
+		void Sample(float t, float *out);
+		// Forgets the cached key positions
+		void Reset();
+	  private:
+		Sampler() = default;
+		bool AddChannel(const std::shared_ptr<source_engine::dmx::Element> &source, std::string &outErr);
+		uint32_t FindKey(size_t channelIdx, float t);
+
+		std::vector<Channel> m_channels;
+		std::vector<uint32_t> m_cursors;
+		std::vector<float> m_times;
+		std::vector<float> m_values;
+		size_t m_outputSize = 0;
+		float m_startTime = 0.f;
+		float m_endTime = 0.f;
+	};
+};
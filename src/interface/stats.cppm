@@ -0,0 +1,75 @@
+// SPDX-FileCopyrightText: (c) 2020 Silverlan <opensource@pragma-engine.com>
+// SPDX-License-Identifier: MIT
+
+export module pragma.modules.dmx:stats;
+
+export import pragma.shared;
+export import source_engine.dmx;
+
+export namespace pragma::modules::dmx {
+	// Recorded while a file is being loaded
+	struct LoadStats {
+		// Parsed from the "<!-- dmx encoding ... format ... -->" header
+		std::string encoding;
+		int32_t encodingVersion = -1;
+		std::string format;
+		int32_t formatVersion = -1;
+		uint64_t bytesRead = 0;
+		double headerTimeMs = 0.0;
+		// Time spent in FileData::Load (string table, elements, attribute values and link resolution)
+		double parseTimeMs = 0.0;
+	};
+
+	// Derived from the element graph on request
+	struct ContentStats {
+		uint64_t elementCount = 0;
+		uint64_t attributeCount = 0;
+		std::map<source_engine::dmx::AttrType, uint64_t> attributesByType;
+		uint64_t arrayEntryCount = 0;
+		uint64_t arrayPayloadBytes = 0;
+		size_t estimatedMemory = 0;
+		double analyzeTimeMs = 0.0;
+		static ContentStats Compute(source_engine::dmx::FileData &data);
+	};
+
+	// Reads the header of a DMX file without consuming it
+	bool read_header(ufile::IFile &f, LoadStats &outStats);
+
+	// Call counters for the Lua-facing hot paths, only updated while profiling is enabled
+	enum class Counter : uint8_t {
+		GetValue = 0,
+		Get,
+		GetAttr,
+		GetAttributes,
+		GetElements,
+		ToString,
+
+		Count,
+	};
+	constexpr std::string_view counter_to_string(Counter counter)
+	{
+		switch(counter) {
+		case Counter::GetValue:
+			return "GetValue";
+		case Counter::Get:
+			return "Get";
+		case Counter::GetAttr:
+			return "GetAttr";
+		case Counter::GetAttributes:
+			return "GetAttributes";
+		case Counter::GetElements:
+			return "GetElements";
+		case Counter::ToString:
+			return "ToString";
+		case Counter::Count:
+		default:
+			break;
+		}
+		return "";
+	}
+	void set_profiling_enabled(bool enabled);
+	bool is_profiling_enabled();
+	void increment_counter(Counter counter, uint64_t n = 1);
+	uint64_t get_counter(Counter counter);
+	void reset_counters();
+};
@@ -0,0 +1,40 @@
+// SPDX-FileCopyrightText: (c) 2020 Silverlan <opensource@pragma-engine.com>
+// SPDX-License-Identifier: MIT
+
+export module pragma.modules.dmx:thread_pool;
+
+export import pragma.shared;
+
+export namespace pragma::modules::dmx {
+	// Number of worker threads to use if the caller did not specify one
+	uint32_t get_default_thread_count();
+
+	// Fixed set of worker threads shared by all background work of the module (asynchronous loads, parallel_for),
+	// so the number of threads stays bounded no matter how many jobs are started.
+	class ThreadPool {
+	  public:
+		static ThreadPool &Get();
+		ThreadPool(const ThreadPool &) = delete;
+		ThreadPool &operator=(const ThreadPool &) = delete;
+		// Runs the tasks that are still queued, then joins the workers
+		~ThreadPool();
+
+		// Tasks are run in the order they were enqueued. They must not throw, exceptions are discarded.
+		void Enqueue(std::function<void()> task);
+		uint32_t GetThreadCount() const { return static_cast<uint32_t>(m_threads.size()); }
+	  private:
+		ThreadPool(uint32_t threadCount);
+		void Run();
+		std::vector<std::thread> m_threads;
+		std::deque<std::function<void()>> m_tasks;
+		std::mutex m_mutex;
+		std::condition_variable m_condition;
+		bool m_stop = false;
+	};
+
+	// Calls 'fn' for every index in [0, count) on up to 'threadCount' threads (the calling thread and workers of the ThreadPool).
+	// Indices are handed out one at a time, so threads that finish early pick up the remaining work. The calling thread
+	// works as well, so this completes even if all workers are busy, e.g. when called from a pool task.
+	// The first exception thrown by 'fn' is rethrown once all threads have finished.
+	void parallel_for(size_t count, uint32_t threadCount, const std::function<void(size_t)> &fn);
+};